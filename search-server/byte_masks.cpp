@@ -0,0 +1,141 @@
+#include "byte_masks.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define BYTE_MASKS_X86_64
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define BYTE_MASKS_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define BYTE_MASKS_TARGET_AVX2
+#endif
+
+#ifndef BYTE_MASKS_X86_64
+static uint64_t ScalarSpaceMask(const char* block)
+{
+	uint64_t mask = 0;
+	for (int i = 0; i < BYTE_MASK_BLOCK_SIZE; ++i) {
+		mask |= static_cast<uint64_t>(block[i] == ' ') << i;
+	}
+	return mask;
+}
+
+static uint64_t ScalarControlMask(const char* block)
+{
+	uint64_t mask = 0;
+	for (int i = 0; i < BYTE_MASK_BLOCK_SIZE; ++i) {
+		mask |= static_cast<uint64_t>(static_cast<unsigned char>(block[i]) < ' ') << i;
+	}
+	return mask;
+}
+#endif
+
+#ifdef BYTE_MASKS_X86_64
+// SSE2 is part of x86-64, so these need no runtime check
+static uint64_t Sse2SpaceMask(const char* block)
+{
+	const __m128i spaces = _mm_set1_epi8(' ');
+	uint64_t mask = 0;
+	for (int i = 0; i < BYTE_MASK_BLOCK_SIZE; i += 16) {
+		const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i));
+		const uint64_t part = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, spaces)));
+		mask |= part << i;
+	}
+	return mask;
+}
+
+static uint64_t Sse2ControlMask(const char* block)
+{
+	// byte <= 31 as unsigned exactly when min(byte, 31) == byte
+	const __m128i max_control = _mm_set1_epi8(' ' - 1);
+	uint64_t mask = 0;
+	for (int i = 0; i < BYTE_MASK_BLOCK_SIZE; i += 16) {
+		const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i));
+		const __m128i is_control = _mm_cmpeq_epi8(_mm_min_epu8(bytes, max_control), bytes);
+		const uint64_t part = static_cast<uint32_t>(_mm_movemask_epi8(is_control));
+		mask |= part << i;
+	}
+	return mask;
+}
+
+static BYTE_MASKS_TARGET_AVX2 uint64_t Avx2SpaceMask(const char* block)
+{
+	const __m256i spaces = _mm256_set1_epi8(' ');
+	const __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+	const __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32));
+	const uint64_t low_mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, spaces)));
+	const uint64_t high_mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, spaces)));
+	return low_mask | (high_mask << 32);
+}
+
+static BYTE_MASKS_TARGET_AVX2 uint64_t Avx2ControlMask(const char* block)
+{
+	const __m256i max_control = _mm256_set1_epi8(' ' - 1);
+	const __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+	const __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32));
+	const __m256i low_control = _mm256_cmpeq_epi8(_mm256_min_epu8(low, max_control), low);
+	const __m256i high_control = _mm256_cmpeq_epi8(_mm256_min_epu8(high, max_control), high);
+	const uint64_t low_mask = static_cast<uint32_t>(_mm256_movemask_epi8(low_control));
+	const uint64_t high_mask = static_cast<uint32_t>(_mm256_movemask_epi8(high_control));
+	return low_mask | (high_mask << 32);
+}
+
+static bool CpuSupportsAvx2()
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_cpu_supports("avx2");
+#elif defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7) {
+		return false;
+	}
+	__cpuid(info, 1);
+	const bool os_saves_ymm = (info[2] & (1 << 27)) && (_xgetbv(0) & 6) == 6;
+	__cpuidex(info, 7, 0);
+	return os_saves_ymm && (info[1] & (1 << 5));
+#else
+	return false;
+#endif
+}
+#endif
+
+static ByteMaskKernels SelectByteMaskKernels()
+{
+#ifdef BYTE_MASKS_X86_64
+	if (CpuSupportsAvx2()) {
+		return { Avx2SpaceMask, Avx2ControlMask };
+	}
+	return { Sse2SpaceMask, Sse2ControlMask };
+#else
+	return { ScalarSpaceMask, ScalarControlMask };
+#endif
+}
+
+const ByteMaskKernels& GetByteMaskKernels()
+{
+	static const ByteMaskKernels kernels = SelectByteMaskKernels();
+	return kernels;
+}
+
+int CountTrailingZeros(uint64_t mask)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_ctzll(mask);
+#elif defined(_MSC_VER) && defined(BYTE_MASKS_X86_64)
+	unsigned long index;
+	_BitScanForward64(&index, mask);
+	return static_cast<int>(index);
+#else
+	int count = 0;
+	while ((mask & 1) == 0) {
+		mask >>= 1;
+		++count;
+	}
+	return count;
+#endif
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include <cstdint>
+
+// Kernels classifying a block of 64 bytes at once: bit i of the result
+// is set when byte i of the block matches. The implementation is chosen
+// at first use from what the CPU supports: AVX2, SSE2 or plain scalar code.
+constexpr int BYTE_MASK_BLOCK_SIZE = 64;
+
+using ByteMaskFunction = uint64_t(*)(const char* block);
+
+struct ByteMaskKernels {
+	// bytes equal to ' '
+	ByteMaskFunction space_mask;
+	// control characters, i.e. bytes from 0 to 31
+	ByteMaskFunction control_mask;
+};
+
+const ByteMaskKernels& GetByteMaskKernels();
+
+int CountTrailingZeros(uint64_t mask);
@@ -0,0 +1,97 @@
+#include "compressed_postings.h"
+
+CompressedPostings::CompressedPostings(const std::pmr::vector<int>& document_ids,
+	const std::pmr::vector<double>& term_freqs, std::pmr::memory_resource* resource)
+	: size_(document_ids.size())
+	, block_first_ids_(resource)
+	, block_offsets_(resource)
+	, bytes_(resource)
+	, term_freq_values_(term_freqs.begin(), term_freqs.end(), resource)
+{
+	std::sort(term_freq_values_.begin(), term_freq_values_.end());
+	term_freq_values_.erase(std::unique(term_freq_values_.begin(), term_freq_values_.end()),
+		term_freq_values_.end());
+	term_freq_values_.shrink_to_fit();
+
+	const size_t block_count = (size_ + BLOCK_SIZE - 1) / BLOCK_SIZE;
+	block_first_ids_.reserve(block_count);
+	block_offsets_.reserve(block_count);
+	for (size_t i = 0; i < size_; ++i) {
+		if (i % BLOCK_SIZE == 0) {
+			block_first_ids_.push_back(document_ids[i]);
+			block_offsets_.push_back(static_cast<uint32_t>(bytes_.size()));
+		}
+		else {
+			WriteVarint(bytes_, static_cast<uint32_t>(document_ids[i] - document_ids[i - 1]));
+		}
+		const auto value = std::lower_bound(term_freq_values_.begin(), term_freq_values_.end(), term_freqs[i]);
+		WriteVarint(bytes_, static_cast<uint32_t>(value - term_freq_values_.begin()));
+	}
+	bytes_.shrink_to_fit();
+}
+
+size_t CompressedPostings::size() const
+{
+	return size_;
+}
+
+bool CompressedPostings::Contains(int document_id) const
+{
+	bool is_found = false;
+	ForEachInRange(document_id, document_id + 1, [&is_found](int, double) {
+		is_found = true;
+	});
+	return is_found;
+}
+
+void CompressedPostings::Decode(std::pmr::vector<int>& document_ids, std::pmr::vector<double>& term_freqs) const
+{
+	document_ids.clear();
+	term_freqs.clear();
+	document_ids.reserve(size_);
+	term_freqs.reserve(size_);
+	ForEach([&document_ids, &term_freqs](int document_id, double term_freq) {
+		document_ids.push_back(document_id);
+		term_freqs.push_back(term_freq);
+	});
+}
+
+size_t CompressedPostings::GetByteSize() const
+{
+	return block_first_ids_.capacity() * sizeof(int)
+		+ block_offsets_.capacity() * sizeof(uint32_t)
+		+ bytes_.capacity()
+		+ term_freq_values_.capacity() * sizeof(double);
+}
+
+size_t CompressedPostings::GetBlockCount() const
+{
+	return block_first_ids_.size();
+}
+
+size_t CompressedPostings::FindBlock(int document_id) const
+{
+	const auto it = std::upper_bound(block_first_ids_.begin(), block_first_ids_.end(), document_id);
+	return it == block_first_ids_.begin() ? 0 : it - block_first_ids_.begin() - 1;
+}
+
+size_t CompressedPostings::DecodeBlock(size_t block, int* document_ids, double* term_freqs) const
+{
+	size_t count = 0;
+	auto visitor = [document_ids, term_freqs, &count](int document_id, double term_freq) {
+		document_ids[count] = document_id;
+		term_freqs[count] = term_freq;
+		++count;
+	};
+	VisitBlock(block, INT32_MAX, visitor);
+	return count;
+}
+
+void CompressedPostings::WriteVarint(std::pmr::vector<uint8_t>& bytes, uint32_t value)
+{
+	while (value >= 0x80) {
+		bytes.push_back(static_cast<uint8_t>(value | 0x80));
+		value >>= 7;
+	}
+	bytes.push_back(static_cast<uint8_t>(value));
+}
@@ -0,0 +1,123 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+// Read-only compressed form of a posting list.
+// Postings are cut into blocks of BLOCK_SIZE; the first document id of every
+// block is kept uncompressed, so a search or a range scan skips whole blocks,
+// and inside a block the ids are stored as varint gaps. Term frequencies are
+// replaced by varint indexes into the table of distinct frequencies of the
+// list. A term frequency is a word count divided by the document length, so
+// the table is usually short and the encoding is lossless: decoded values are
+// equal to the original ones bit for bit.
+// A posting takes a varint gap (one byte below 128) and a varint table index
+// (one byte while the list has at most 128 distinct frequencies), and the
+// list adds 8 bytes per distinct frequency and 8 bytes per block. The table
+// of a long list with varied document lengths may outweigh the savings;
+// PostingList keeps such lists plain
+class CompressedPostings {
+public:
+	CompressedPostings(const std::pmr::vector<int>& document_ids,
+		const std::pmr::vector<double>& term_freqs,
+		std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+	size_t size() const;
+
+	bool Contains(int document_id) const;
+
+	// calls visitor(document_id, term_freq) for every posting,
+	// ids ascending
+	template <typename Visitor>
+	void ForEach(Visitor visitor) const
+	{
+		for (size_t block = 0; block < block_first_ids_.size(); ++block) {
+			if (!VisitBlock(block, INT32_MAX, visitor)) {
+				return;
+			}
+		}
+	}
+
+	// the same for the postings with first_id <= document id < last_id
+	template <typename Visitor>
+	void ForEachInRange(int first_id, int last_id, Visitor visitor) const
+	{
+		auto range_visitor = [first_id, &visitor](int document_id, double term_freq) {
+			if (document_id >= first_id) {
+				visitor(document_id, term_freq);
+			}
+		};
+		for (size_t block = FindBlock(first_id); block < block_first_ids_.size()
+			&& block_first_ids_[block] < last_id; ++block) {
+			if (!VisitBlock(block, last_id, range_visitor)) {
+				return;
+			}
+		}
+	}
+
+	void Decode(std::pmr::vector<int>& document_ids, std::pmr::vector<double>& term_freqs) const;
+
+	static constexpr size_t BLOCK_SIZE = 128;
+
+	size_t GetBlockCount() const;
+
+	// index of the block which may contain document_id
+	size_t FindBlock(int document_id) const;
+
+	// decodes the block into arrays of BLOCK_SIZE elements,
+	// returns the number of postings in the block
+	size_t DecodeBlock(size_t block, int* document_ids, double* term_freqs) const;
+
+	// bytes held by the encoded postings and the tables
+	size_t GetByteSize() const;
+
+private:
+	size_t size_ = 0;
+	std::pmr::vector<int> block_first_ids_;
+	// start of every block in bytes_
+	std::pmr::vector<uint32_t> block_offsets_;
+	// (id gap, term frequency index) varint pairs, the gap is omitted
+	// for the first posting of a block
+	std::pmr::vector<uint8_t> bytes_;
+	std::pmr::vector<double> term_freq_values_;
+
+	// calls the visitor for the postings of the block with ids below last_id,
+	// returns false if an id not below last_id was met
+	template <typename Visitor>
+	bool VisitBlock(size_t block, int last_id, Visitor& visitor) const
+	{
+		const size_t count = std::min(BLOCK_SIZE, size_ - block * BLOCK_SIZE);
+		const uint8_t* data = bytes_.data() + block_offsets_[block];
+		int document_id = block_first_ids_[block];
+		for (size_t i = 0; i < count; ++i) {
+			if (i > 0) {
+				document_id += static_cast<int>(ReadVarint(data));
+			}
+			if (document_id >= last_id) {
+				return false;
+			}
+			visitor(document_id, term_freq_values_[ReadVarint(data)]);
+		}
+		return true;
+	}
+
+	static uint32_t ReadVarint(const uint8_t*& data)
+	{
+		// one byte covers almost every gap of a frequent term
+		uint32_t value = *data++;
+		if (value < 0x80) {
+			return value;
+		}
+		value &= 0x7f;
+		for (int shift = 7; ; shift += 7) {
+			const uint32_t byte = *data++;
+			value |= (byte & 0x7f) << shift;
+			if (byte < 0x80) {
+				return value;
+			}
+		}
+	}
+
+	static void WriteVarint(std::pmr::vector<uint8_t>& bytes, uint32_t value);
+};
@@ -1,57 +1,290 @@
 #pragma once
+#include <algorithm>
+#include <cstdint>
 #include <cstdlib>
+#include <functional>
 #include <map>
 #include <mutex>
-#include <string>
+#include <optional>
+#include <shared_mutex>
+#include <utility>
 #include <vector>
 
-using namespace std::string_literals;
-
-template <typename Key, typename Value>
+// Hash map split into independently locked buckets. Every bucket is an open
+// addressed table with linear probing guarded by a reader/writer lock and
+// padded to its own cache line, so threads working on different buckets
+// never contend on a lock or share a line.
+// Key and Value must be default constructible; string_view keys are allowed,
+// the caller keeps the viewed strings alive while they are in the map.
+template <typename Key, typename Value,
+	typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
 class ConcurrentMap {
 private:
-	struct Bucket {
-		std::mutex mutex;
-		std::map<Key, Value> map;
+	static constexpr size_t CACHE_LINE_SIZE = 64;
+	static constexpr size_t MIN_SLOT_COUNT = 8;
+
+	enum class SlotState : char {
+		EMPTY,
+		FULL,
+		DELETED,
 	};
 
-public:
-	static_assert(std::is_integral_v<Key>, "ConcurrentMap supports only integer keys"s);
+	struct Slot {
+		Key key{};
+		Value value{};
+		SlotState state = SlotState::EMPTY;
+	};
 
+	struct alignas(CACHE_LINE_SIZE) Bucket {
+		mutable std::shared_mutex mutex;
+		std::vector<Slot> slots;
+		size_t size = 0;
+		// full and deleted slots, deleted ones still lengthen probe sequences
+		size_t used = 0;
+	};
+
+public:
 	struct Access {
-		std::lock_guard<std::mutex> guard;
+		std::unique_lock<std::shared_mutex> guard;
 		Value& ref_to_value;
 
-		Access(const Key& key, Bucket& bucket)
+		Access(const Key& key, Bucket& bucket, size_t hash, ConcurrentMap& map)
 			: guard(bucket.mutex)
-			, ref_to_value(bucket.map[key]) {
+			, ref_to_value(map.Emplace(bucket, key, hash).first->value) {
 		}
 	};
 
-	explicit ConcurrentMap(size_t bucket_count)
-		: buckets_(bucket_count) {
+	explicit ConcurrentMap(size_t bucket_count, Hash hash = Hash{}, KeyEqual key_equal = KeyEqual{})
+		: buckets_(std::max<size_t>(bucket_count, 1))
+		, hash_(std::move(hash))
+		, key_equal_(std::move(key_equal)) {
 	}
 
+	// locks the bucket of the key until the returned Access is destroyed,
+	// inserting a default constructed value if the key is absent
 	Access operator[](const Key& key) {
-		auto& bucket = buckets_[static_cast<uint64_t>(key) % buckets_.size()];
-		return { key, bucket };
+		const size_t hash = HashOf(key);
+		return { key, GetBucket(hash), hash, *this };
 	}
 
-	std::map<Key, Value> BuildOrdinaryMap() {
-		std::map<Key, Value> result;
-		for (auto&[mutex, map] : buckets_) {
-			std::lock_guard g(mutex);
-			result.insert(map.begin(), map.end());
+	std::optional<Value> Find(const Key& key) const {
+		const size_t hash = HashOf(key);
+		const Bucket& bucket = GetBucket(hash);
+		std::shared_lock guard(bucket.mutex);
+		const Slot* slot = FindSlot(bucket, key, hash);
+		if (slot == nullptr) {
+			return std::nullopt;
+		}
+		return slot->value;
+	}
+
+	bool Contains(const Key& key) const {
+		const size_t hash = HashOf(key);
+		const Bucket& bucket = GetBucket(hash);
+		std::shared_lock guard(bucket.mutex);
+		return FindSlot(bucket, key, hash) != nullptr;
+	}
+
+	// returns true if the key was inserted, false if its value was replaced
+	bool InsertOrAssign(const Key& key, Value value) {
+		const size_t hash = HashOf(key);
+		Bucket& bucket = GetBucket(hash);
+		std::lock_guard guard(bucket.mutex);
+		auto [slot, inserted] = Emplace(bucket, key, hash);
+		slot->value = std::move(value);
+		return inserted;
+	}
+
+	size_t Erase(const Key& key) {
+		const size_t hash = HashOf(key);
+		Bucket& bucket = GetBucket(hash);
+		std::lock_guard guard(bucket.mutex);
+		Slot* slot = const_cast<Slot*>(FindSlot(bucket, key, hash));
+		if (slot == nullptr) {
+			return 0;
+		}
+		slot->state = SlotState::DELETED;
+		slot->value = Value{};
+		--bucket.size;
+		return 1;
+	}
+
+	// calls func(key, value) for every element, one bucket at a time under
+	// a shared lock; func must not access this map
+	template <typename Func>
+	void ForEach(Func func) const {
+		for (const Bucket& bucket : buckets_) {
+			std::shared_lock guard(bucket.mutex);
+			for (const Slot& slot : bucket.slots) {
+				if (slot.state == SlotState::FULL) {
+					func(slot.key, slot.value);
+				}
+			}
+		}
+	}
+
+	// same as above, but func may modify the value
+	template <typename Func>
+	void ForEach(Func func) {
+		for (Bucket& bucket : buckets_) {
+			std::lock_guard guard(bucket.mutex);
+			for (Slot& slot : bucket.slots) {
+				if (slot.state == SlotState::FULL) {
+					func(slot.key, slot.value);
+				}
+			}
+		}
+	}
+
+	// merges a range of (key, value) pairs taking every bucket lock once;
+	// combine(existing_value, value) is called for keys already present
+	template <typename PairRange, typename Combine>
+	void Merge(const PairRange& items, Combine combine) {
+		std::vector<std::vector<std::pair<size_t, const typename PairRange::value_type*>>> by_bucket(buckets_.size());
+		for (const auto& item : items) {
+			const size_t hash = HashOf(item.first);
+			by_bucket[hash % buckets_.size()].emplace_back(hash, &item);
+		}
+		for (size_t index = 0; index < buckets_.size(); ++index) {
+			if (by_bucket[index].empty()) {
+				continue;
+			}
+			Bucket& bucket = buckets_[index];
+			std::lock_guard guard(bucket.mutex);
+			for (const auto& [hash, item] : by_bucket[index]) {
+				auto [slot, inserted] = Emplace(bucket, item->first, hash);
+				if (inserted) {
+					slot->value = item->second;
+				}
+				else {
+					combine(slot->value, item->second);
+				}
+			}
+		}
+	}
+
+	template <typename PairRange>
+	void Merge(const PairRange& items) {
+		Merge(items, [](Value& value, const Value& new_value) {
+			value = new_value;
+		});
+	}
+
+	size_t size() const {
+		size_t result = 0;
+		for (const Bucket& bucket : buckets_) {
+			std::shared_lock guard(bucket.mutex);
+			result += bucket.size;
 		}
 		return result;
 	}
 
-	auto Erase(const Key& key) {
-		uint64_t tmp_key = static_cast<uint64_t>(key) % buckets_.size();
-		std::lock_guard guard(buckets_[tmp_key].mutex);
-		return buckets_[tmp_key].map.erase(key);
+	void Clear() {
+		for (Bucket& bucket : buckets_) {
+			std::lock_guard guard(bucket.mutex);
+			bucket.slots.clear();
+			bucket.size = 0;
+			bucket.used = 0;
+		}
+	}
+
+	std::map<Key, Value> BuildOrdinaryMap() const {
+		std::map<Key, Value> result;
+		ForEach([&result](const Key& key, const Value& value) {
+			result.emplace(key, value);
+		});
+		return result;
 	}
 
 private:
 	std::vector<Bucket> buckets_;
+	Hash hash_;
+	KeyEqual key_equal_;
+
+	size_t HashOf(const Key& key) const {
+		// std::hash of integers is the identity, mix the bits so that
+		// both the bucket and the slot index get well distributed values
+		uint64_t hash = static_cast<uint64_t>(hash_(key));
+		hash ^= hash >> 33;
+		hash *= 0xff51afd7ed558ccdULL;
+		hash ^= hash >> 33;
+		hash *= 0xc4ceb9fe1a85ec53ULL;
+		hash ^= hash >> 33;
+		return static_cast<size_t>(hash);
+	}
+
+	Bucket& GetBucket(size_t hash) {
+		return buckets_[hash % buckets_.size()];
+	}
+
+	const Bucket& GetBucket(size_t hash) const {
+		return buckets_[hash % buckets_.size()];
+	}
+
+	static size_t SlotIndex(size_t hash, size_t slot_count) {
+		// the low bits already chose the bucket
+		return (hash >> 16) & (slot_count - 1);
+	}
+
+	const Slot* FindSlot(const Bucket& bucket, const Key& key, size_t hash) const {
+		if (bucket.slots.empty()) {
+			return nullptr;
+		}
+		const size_t mask = bucket.slots.size() - 1;
+		for (size_t index = SlotIndex(hash, bucket.slots.size());; index = (index + 1) & mask) {
+			const Slot& slot = bucket.slots[index];
+			if (slot.state == SlotState::EMPTY) {
+				return nullptr;
+			}
+			if (slot.state == SlotState::FULL && key_equal_(slot.key, key)) {
+				return &slot;
+			}
+		}
+	}
+
+	// the bucket must be locked exclusively
+	std::pair<Slot*, bool> Emplace(Bucket& bucket, const Key& key, size_t hash) {
+		if (Slot* slot = const_cast<Slot*>(FindSlot(bucket, key, hash))) {
+			return { slot, false };
+		}
+		if ((bucket.used + 1) * 4 > bucket.slots.size() * 3) {
+			Rehash(bucket);
+		}
+		const size_t mask = bucket.slots.size() - 1;
+		size_t index = SlotIndex(hash, bucket.slots.size());
+		while (bucket.slots[index].state == SlotState::FULL) {
+			index = (index + 1) & mask;
+		}
+		Slot& slot = bucket.slots[index];
+		if (slot.state == SlotState::EMPTY) {
+			++bucket.used;
+		}
+		slot.key = key;
+		slot.value = Value{};
+		slot.state = SlotState::FULL;
+		++bucket.size;
+		return { &slot, true };
+	}
+
+	void Rehash(Bucket& bucket) {
+		// grow only if live elements need it, otherwise just drop deleted slots
+		size_t slot_count = std::max(bucket.slots.size(), MIN_SLOT_COUNT);
+		while ((bucket.size + 1) * 2 > slot_count) {
+			slot_count *= 2;
+		}
+		std::vector<Slot> old_slots(slot_count);
+		old_slots.swap(bucket.slots);
+		const size_t mask = slot_count - 1;
+		for (Slot& old_slot : old_slots) {
+			if (old_slot.state != SlotState::FULL) {
+				continue;
+			}
+			size_t index = SlotIndex(HashOf(old_slot.key), slot_count);
+			while (bucket.slots[index].state == SlotState::FULL) {
+				index = (index + 1) & mask;
+			}
+			bucket.slots[index] = std::move(old_slot);
+		}
+		bucket.used = bucket.size;
+	}
 };
@@ -0,0 +1,80 @@
+#include "concurrent_search_server.h"
+
+ConcurrentSearchServer::ConcurrentSearchServer(const std::string& stop_words_text)
+	: servers_{ std::make_unique<SearchServer>(stop_words_text), std::make_unique<SearchServer>(stop_words_text) }
+	, standby_(servers_[1].get())
+{
+	published_ = Publish(servers_[0].get(), published_released_);
+}
+
+std::shared_ptr<const SearchServer> ConcurrentSearchServer::GetSnapshot() const
+{
+	return std::atomic_load(&published_);
+}
+
+int ConcurrentSearchServer::GetDocumentCount() const
+{
+	return GetSnapshot()->GetDocumentCount();
+}
+
+void ConcurrentSearchServer::AddDocument(int document_id, std::string_view document,
+	DocumentStatus status, const std::vector<int>& ratings)
+{
+	Modify([document_id, document, status, &ratings](SearchServer& server) {
+		server.AddDocument(document_id, document, status, ratings);
+	});
+}
+
+void ConcurrentSearchServer::AddDocuments(const std::vector<RawDocument>& documents)
+{
+	Modify([&documents](SearchServer& server) {
+		server.AddDocuments(std::execution::par, documents);
+	});
+}
+
+void ConcurrentSearchServer::RemoveDocument(int document_id)
+{
+	Modify([document_id](SearchServer& server) {
+		server.RemoveDocument(document_id);
+	});
+}
+
+void ConcurrentSearchServer::RemoveDocuments(const std::vector<int>& document_ids)
+{
+	Modify([&document_ids](SearchServer& server) {
+		server.RemoveDocuments(std::execution::par, document_ids);
+	});
+}
+
+void ConcurrentSearchServer::RebuildStandby()
+{
+	const std::shared_ptr<const SearchServer> source = GetSnapshot();
+	auto rebuilt = std::make_unique<SearchServer>(source->stop_words_, source->forward_index_mode_);
+	rebuilt->SetRemovalMode(source->removal_mode_);
+	if (source->query_cache_) {
+		rebuilt->SetQueryCacheCapacity(source->query_cache_->GetCapacity());
+	}
+	// the average rating is the only rating of a document
+	std::vector<RawDocument> documents;
+	documents.reserve(source->GetDocumentCount());
+	for (const int document_id : *source) {
+		const auto& document = source->documents_[source->document_ordinals_.at(document_id)];
+		documents.push_back({ document_id, document.data, document.status, { document.rating } });
+	}
+	rebuilt->AddDocuments(std::execution::par, documents);
+
+	auto& standby = servers_[0].get() == standby_ ? servers_[0] : servers_[1];
+	standby = std::move(rebuilt);
+	standby_ = standby.get();
+	is_standby_stale_ = false;
+}
+
+std::shared_ptr<SearchServer> ConcurrentSearchServer::Publish(SearchServer* server,
+	std::future<void>& released)
+{
+	auto promise = std::make_shared<std::promise<void>>();
+	released = promise->get_future();
+	return std::shared_ptr<SearchServer>(server, [promise](SearchServer*) {
+		promise->set_value();
+	});
+}
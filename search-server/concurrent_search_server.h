@@ -0,0 +1,114 @@
+#pragma once
+#include "search_server.h"
+
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// SearchServer which may be queried while it is being modified.
+// Two copies of the index are kept: readers take the published one through
+// an atomic shared pointer and never wait, a writer changes the other copy,
+// publishes it and then repeats the change on the copy readers have left.
+// Writes are serialized and wait only for queries that started on the
+// previous version; a query sees either the whole write or none of it
+class ConcurrentSearchServer {
+public:
+	template <typename StringContainer>
+	explicit ConcurrentSearchServer(const StringContainer& stop_words)
+		: servers_{ std::make_unique<SearchServer>(stop_words), std::make_unique<SearchServer>(stop_words) }
+		, standby_(servers_[1].get())
+	{
+		published_ = Publish(servers_[0].get(), published_released_);
+	}
+
+	explicit ConcurrentSearchServer(const std::string& stop_words_text);
+
+	// current version of the index, it doesn't change while the pointer is held;
+	// the pointer must not outlive the ConcurrentSearchServer. A write waits
+	// until the snapshots of the version before it are released, so a thread
+	// must not modify the server while it holds a snapshot: it would wait
+	// for itself forever
+	std::shared_ptr<const SearchServer> GetSnapshot() const;
+
+	template <typename... Args>
+	std::vector<Document> FindTopDocuments(Args&&... args) const
+	{
+		return GetSnapshot()->FindTopDocuments(std::forward<Args>(args)...);
+	}
+
+	// matched words are views into the query, so they outlive the snapshot
+	template <typename... Args>
+	std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(Args&&... args) const
+	{
+		return GetSnapshot()->MatchDocument(std::forward<Args>(args)...);
+	}
+
+	int GetDocumentCount() const;
+
+	void AddDocument(int document_id, std::string_view document,
+		DocumentStatus status, const std::vector<int>& ratings);
+
+	void AddDocuments(const std::vector<RawDocument>& documents);
+
+	void RemoveDocument(int document_id);
+
+	void RemoveDocuments(const std::vector<int>& document_ids);
+
+	// Applies update(SearchServer&) to both copies of the index. The update
+	// must change them the same way, so it has to depend on its argument only.
+	// If it throws on the first copy nothing is published, and it must leave
+	// the copy unchanged then, as the SearchServer methods do. If it throws on
+	// the second copy, the change is already published: the second copy is
+	// rebuilt from the published one, O(index), and the exception is rethrown.
+	// Deadlocks if the calling thread holds a snapshot, see GetSnapshot
+	template <typename Update>
+	void Modify(Update update)
+	{
+		std::lock_guard guard(write_mutex_);
+		if (is_standby_stale_) {
+			RebuildStandby();
+		}
+		update(*standby_);
+		std::future<void> standby_released;
+		std::shared_ptr<SearchServer> previous = std::atomic_exchange(&published_,
+			Publish(standby_, standby_released));
+		standby_ = previous.get();
+		previous.reset();
+		// queries which took the previous version before the exchange
+		published_released_.wait();
+		published_released_ = std::move(standby_released);
+		try {
+			update(*standby_);
+		}
+		catch (...) {
+			// a failed rebuild is retried by the next write
+			is_standby_stale_ = true;
+			RebuildStandby();
+			throw;
+		}
+	}
+
+private:
+	std::mutex write_mutex_;
+	std::unique_ptr<SearchServer> servers_[2];
+	// the published copy, accessed only with the atomic shared_ptr functions;
+	// the pointer doesn't own the copy, the release of its last reference
+	// makes published_released_ ready
+	std::shared_ptr<SearchServer> published_;
+	std::future<void> published_released_;
+	// the copy no reader can reach
+	SearchServer* standby_ = nullptr;
+	// set when an update failed halfway on the standby copy
+	bool is_standby_stale_ = false;
+
+	static std::shared_ptr<SearchServer> Publish(SearchServer* server, std::future<void>& released);
+
+	// replaces the standby copy by a new server with the documents and the
+	// settings of the published one; must be called under write_mutex_
+	void RebuildStandby();
+};
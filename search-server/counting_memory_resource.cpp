@@ -0,0 +1,45 @@
+#include "counting_memory_resource.h"
+
+CountingMemoryResource::CountingMemoryResource(std::pmr::memory_resource* upstream)
+	: upstream_(upstream)
+{
+}
+
+MemoryResourceStats CountingMemoryResource::GetStats() const
+{
+	MemoryResourceStats stats;
+	stats.bytes_in_use = bytes_in_use_.load(std::memory_order_relaxed);
+	stats.peak_bytes_in_use = peak_bytes_in_use_.load(std::memory_order_relaxed);
+	stats.allocation_count = allocation_count_.load(std::memory_order_relaxed);
+	stats.deallocation_count = deallocation_count_.load(std::memory_order_relaxed);
+	return stats;
+}
+
+std::pmr::memory_resource* CountingMemoryResource::GetUpstream() const
+{
+	return upstream_;
+}
+
+void* CountingMemoryResource::do_allocate(size_t bytes, size_t alignment)
+{
+	void* pointer = upstream_->allocate(bytes, alignment);
+	allocation_count_.fetch_add(1, std::memory_order_relaxed);
+	const size_t bytes_in_use = bytes_in_use_.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+	size_t peak = peak_bytes_in_use_.load(std::memory_order_relaxed);
+	while (peak < bytes_in_use
+		&& !peak_bytes_in_use_.compare_exchange_weak(peak, bytes_in_use, std::memory_order_relaxed)) {
+	}
+	return pointer;
+}
+
+void CountingMemoryResource::do_deallocate(void* pointer, size_t bytes, size_t alignment)
+{
+	upstream_->deallocate(pointer, bytes, alignment);
+	deallocation_count_.fetch_add(1, std::memory_order_relaxed);
+	bytes_in_use_.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+bool CountingMemoryResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+	return this == &other;
+}
@@ -1,8 +1,8 @@
-#include "document.h"
-
-Document::Document(int id, double relevance, int rating)
-	: id(id)
-	, relevance(relevance)
-	, rating(rating)
-{
+#include "document.h"
+
+Document::Document(int id, double relevance, int rating)
+	: id(id)
+	, relevance(relevance)
+	, rating(rating)
+{
 }
\ No newline at end of file
@@ -1,18 +1,29 @@
-#pragma once
-struct Document
-{
-	Document() = default;
-
-	Document(int id, double relevance, int rating);
-
-	int id = 0;
-	double relevance = 0.0;
-	int rating = 0;
-};
-
-enum class DocumentStatus {
-	ACTUAL,
-	IRRELEVANT,
-	BANNED,
-	REMOVED,
+#pragma once
+#include <string_view>
+#include <vector>
+
+struct Document
+{
+	Document() = default;
+
+	Document(int id, double relevance, int rating);
+
+	int id = 0;
+	double relevance = 0.0;
+	int rating = 0;
+};
+
+enum class DocumentStatus {
+	ACTUAL,
+	IRRELEVANT,
+	BANNED,
+	REMOVED,
+};
+
+// Input of SearchServer::AddDocuments, the text is only viewed
+struct RawDocument {
+	int id = 0;
+	std::string_view text;
+	DocumentStatus status = DocumentStatus::ACTUAL;
+	std::vector<int> ratings;
 };
\ No newline at end of file
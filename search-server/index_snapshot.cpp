@@ -0,0 +1,420 @@
+#include "index_snapshot.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static constexpr char SNAPSHOT_MAGIC[8] = { 'S', 'R', 'C', 'H', 'I', 'D', 'X', '\0' };
+
+static uint64_t AlignOffset(uint64_t offset)
+{
+	return (offset + 7) / 8 * 8;
+}
+
+template <typename T>
+static void WriteSection(std::ofstream& out, uint64_t offset, const std::vector<T>& items)
+{
+	out.seekp(static_cast<std::streamoff>(offset));
+	out.write(reinterpret_cast<const char*>(items.data()), static_cast<std::streamsize>(items.size() * sizeof(T)));
+}
+
+void IndexSnapshot::Save(const SearchServer& search_server, const std::string& path)
+{
+	// documents are renumbered in the order of their ids
+	std::vector<int> new_ordinals(search_server.documents_.size(), -1);
+	std::vector<DocumentEntry> documents;
+	documents.reserve(search_server.document_ids_.size());
+	for (const int document_id : search_server.document_ids_) {
+		const int ordinal = search_server.document_ordinals_.at(document_id);
+		const auto& document_data = search_server.documents_[ordinal];
+		new_ordinals[ordinal] = static_cast<int>(documents.size());
+		documents.push_back({ document_data.id, document_data.rating,
+			static_cast<int32_t>(document_data.status), 0 });
+	}
+
+	std::vector<std::pair<std::string_view, const PostingList*>> sorted_terms;
+	const InvertedIndex& index = search_server.word_to_document_freqs_;
+	for (uint32_t term_id = 0; term_id < index.GetTermCount(); ++term_id) {
+		const PostingList& postings = index.GetPostings(term_id);
+		if (postings.GetDocumentFreq() > 0) {
+			sorted_terms.emplace_back(index.GetTerm(term_id), &postings);
+		}
+	}
+	std::sort(sorted_terms.begin(), sorted_terms.end());
+
+	std::string chars;
+	std::vector<TermEntry> terms;
+	std::vector<int32_t> posting_ordinals;
+	std::vector<double> posting_term_freqs;
+	std::vector<std::pair<int32_t, double>> postings_buffer;
+	for (const auto& [term, postings] : sorted_terms) {
+		postings_buffer.clear();
+		postings->ForEach([&new_ordinals, &postings_buffer](int ordinal, double term_freq) {
+			// documents removed in the deferred mode are still in the lists
+			if (new_ordinals[ordinal] >= 0) {
+				postings_buffer.emplace_back(new_ordinals[ordinal], term_freq);
+			}
+		});
+		std::sort(postings_buffer.begin(), postings_buffer.end());
+
+		terms.push_back({ { chars.size(), term.size() }, posting_ordinals.size(), postings_buffer.size() });
+		chars.append(term);
+		for (const auto& [ordinal, term_freq] : postings_buffer) {
+			posting_ordinals.push_back(ordinal);
+			posting_term_freqs.push_back(term_freq);
+		}
+	}
+
+	std::vector<StringRef> stop_words;
+	for (const std::string& stop_word : search_server.stop_words_) {
+		stop_words.push_back({ chars.size(), stop_word.size() });
+		chars.append(stop_word);
+	}
+
+	// load factor is kept at most one half
+	uint64_t hash_slot_count = 2;
+	while (hash_slot_count < terms.size() * 2) {
+		hash_slot_count *= 2;
+	}
+	std::vector<uint32_t> hash_slots(hash_slot_count, 0);
+	for (size_t index = 0; index < terms.size(); ++index) {
+		uint64_t slot = HashTerm(sorted_terms[index].first) & (hash_slot_count - 1);
+		while (hash_slots[slot] != 0) {
+			slot = (slot + 1) & (hash_slot_count - 1);
+		}
+		hash_slots[slot] = static_cast<uint32_t>(index + 1);
+	}
+
+	Header header{};
+	std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+	header.version = VERSION;
+	header.byte_order_mark = BYTE_ORDER_MARK;
+	header.document_count = documents.size();
+	header.term_count = terms.size();
+	header.posting_count = posting_ordinals.size();
+	header.stop_word_count = stop_words.size();
+	header.hash_slot_count = hash_slot_count;
+	header.documents_offset = AlignOffset(sizeof(Header));
+	header.terms_offset = AlignOffset(header.documents_offset + documents.size() * sizeof(DocumentEntry));
+	header.hash_slots_offset = AlignOffset(header.terms_offset + terms.size() * sizeof(TermEntry));
+	header.posting_ordinals_offset = AlignOffset(header.hash_slots_offset + hash_slots.size() * sizeof(uint32_t));
+	header.posting_term_freqs_offset = AlignOffset(header.posting_ordinals_offset + posting_ordinals.size() * sizeof(int32_t));
+	header.stop_words_offset = AlignOffset(header.posting_term_freqs_offset + posting_term_freqs.size() * sizeof(double));
+	header.chars_offset = AlignOffset(header.stop_words_offset + stop_words.size() * sizeof(StringRef));
+	header.chars_size = chars.size();
+
+	std::ofstream out(path, std::ios::binary | std::ios::trunc);
+	if (!out) {
+		throw std::runtime_error("Can't open snapshot file "s + path + " for writing"s);
+	}
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	WriteSection(out, header.documents_offset, documents);
+	WriteSection(out, header.terms_offset, terms);
+	WriteSection(out, header.hash_slots_offset, hash_slots);
+	WriteSection(out, header.posting_ordinals_offset, posting_ordinals);
+	WriteSection(out, header.posting_term_freqs_offset, posting_term_freqs);
+	WriteSection(out, header.stop_words_offset, stop_words);
+	out.seekp(static_cast<std::streamoff>(header.chars_offset));
+	out.write(chars.data(), static_cast<std::streamsize>(chars.size()));
+	if (!out) {
+		throw std::runtime_error("Can't write snapshot file "s + path);
+	}
+}
+
+IndexSnapshot::IndexSnapshot(const std::string& path, Check check)
+{
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		throw std::runtime_error("Can't open snapshot file "s + path);
+	}
+	LARGE_INTEGER file_size;
+	HANDLE mapping = nullptr;
+	if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0) {
+		mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	}
+	CloseHandle(file);
+	if (mapping == nullptr) {
+		throw std::runtime_error("Can't map snapshot file "s + path);
+	}
+	// the view keeps the mapping alive
+	void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	if (view == nullptr) {
+		throw std::runtime_error("Can't map snapshot file "s + path);
+	}
+	data_ = static_cast<const char*>(view);
+	size_ = static_cast<size_t>(file_size.QuadPart);
+#else
+	const int file = open(path.c_str(), O_RDONLY);
+	if (file < 0) {
+		throw std::runtime_error("Can't open snapshot file "s + path);
+	}
+	struct stat file_stat;
+	void* view = MAP_FAILED;
+	if (fstat(file, &file_stat) == 0 && file_stat.st_size > 0) {
+		view = mmap(nullptr, static_cast<size_t>(file_stat.st_size), PROT_READ, MAP_SHARED, file, 0);
+	}
+	// the mapping stays valid after the descriptor is closed
+	close(file);
+	if (view == MAP_FAILED) {
+		throw std::runtime_error("Can't map snapshot file "s + path);
+	}
+	data_ = static_cast<const char*>(view);
+	size_ = static_cast<size_t>(file_stat.st_size);
+#endif
+	try {
+		CheckLayout(check);
+	}
+	catch (...) {
+		Unmap();
+		throw;
+	}
+	header_ = reinterpret_cast<const Header*>(data_);
+	documents_ = reinterpret_cast<const DocumentEntry*>(data_ + header_->documents_offset);
+	terms_ = reinterpret_cast<const TermEntry*>(data_ + header_->terms_offset);
+	hash_slots_ = reinterpret_cast<const uint32_t*>(data_ + header_->hash_slots_offset);
+	posting_ordinals_ = reinterpret_cast<const int32_t*>(data_ + header_->posting_ordinals_offset);
+	posting_term_freqs_ = reinterpret_cast<const double*>(data_ + header_->posting_term_freqs_offset);
+	stop_words_ = reinterpret_cast<const StringRef*>(data_ + header_->stop_words_offset);
+	chars_ = data_ + header_->chars_offset;
+}
+
+IndexSnapshot::IndexSnapshot(IndexSnapshot&& other) noexcept
+{
+	*this = std::move(other);
+}
+
+IndexSnapshot& IndexSnapshot::operator=(IndexSnapshot&& other) noexcept
+{
+	if (this != &other) {
+		Unmap();
+		data_ = std::exchange(other.data_, nullptr);
+		size_ = std::exchange(other.size_, 0);
+		header_ = std::exchange(other.header_, nullptr);
+		documents_ = std::exchange(other.documents_, nullptr);
+		terms_ = std::exchange(other.terms_, nullptr);
+		hash_slots_ = std::exchange(other.hash_slots_, nullptr);
+		posting_ordinals_ = std::exchange(other.posting_ordinals_, nullptr);
+		posting_term_freqs_ = std::exchange(other.posting_term_freqs_, nullptr);
+		stop_words_ = std::exchange(other.stop_words_, nullptr);
+		chars_ = std::exchange(other.chars_, nullptr);
+	}
+	return *this;
+}
+
+IndexSnapshot::~IndexSnapshot()
+{
+	Unmap();
+}
+
+int IndexSnapshot::GetDocumentCount() const
+{
+	return static_cast<int>(header_->document_count);
+}
+
+std::vector<Document> IndexSnapshot::FindTopDocuments(std::string_view raw_query,
+	DocumentStatus status, size_t max_result_count) const
+{
+	return FindTopDocuments(raw_query,
+		[status](int, DocumentStatus document_status, int) {
+		return document_status == status;
+	}, max_result_count);
+}
+
+std::tuple<std::vector<std::string_view>, DocumentStatus> IndexSnapshot::MatchDocument(
+	std::string_view raw_query, int document_id) const
+{
+	const auto query = ParseQuery(raw_query, [this](std::string_view word) {
+		return IsStopWord(word);
+	});
+	const int ordinal = FindOrdinal(document_id);
+	if (ordinal < 0) {
+		throw std::out_of_range("Document "s + std::to_string(document_id) + " is not in the snapshot"s);
+	}
+	const auto status = static_cast<DocumentStatus>(documents_[ordinal].status);
+
+	std::vector<std::string_view> matched_words;
+	for (std::string_view word : query.minus_words) {
+		const TermEntry* term = FindTerm(word);
+		if (term != nullptr && ContainsOrdinal(*term, ordinal)) {
+			return { matched_words, status };
+		}
+	}
+	for (std::string_view word : query.plus_words) {
+		const TermEntry* term = FindTerm(word);
+		if (term != nullptr && ContainsOrdinal(*term, ordinal)) {
+			matched_words.push_back(word);
+		}
+	}
+	return { matched_words, status };
+}
+
+uint64_t IndexSnapshot::HashTerm(std::string_view term)
+{
+	// FNV-1a, the file must not depend on the standard library implementation
+	uint64_t hash = 14695981039346656037ULL;
+	for (const char c : term) {
+		hash ^= static_cast<unsigned char>(c);
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+void IndexSnapshot::Unmap()
+{
+	if (data_ == nullptr) {
+		return;
+	}
+#ifdef _WIN32
+	UnmapViewOfFile(data_);
+#else
+	munmap(const_cast<char*>(data_), size_);
+#endif
+	data_ = nullptr;
+	size_ = 0;
+}
+
+void IndexSnapshot::CheckLayout(Check check) const
+{
+	const auto fail = [](const std::string& reason) {
+		throw std::runtime_error("Invalid snapshot: "s + reason);
+	};
+	if (size_ < sizeof(Header)) {
+		fail("file is too small"s);
+	}
+	const Header& header = *reinterpret_cast<const Header*>(data_);
+	if (std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0) {
+		fail("wrong magic"s);
+	}
+	if (header.version != VERSION) {
+		fail("unsupported version "s + std::to_string(header.version));
+	}
+	if (header.byte_order_mark != BYTE_ORDER_MARK) {
+		fail("written with another byte order"s);
+	}
+	if (header.hash_slot_count == 0 || (header.hash_slot_count & (header.hash_slot_count - 1)) != 0
+		|| header.hash_slot_count <= header.term_count) {
+		fail("bad hash table size"s);
+	}
+	const auto check_section = [this, &fail](uint64_t offset, uint64_t count, uint64_t item_size) {
+		if (offset % 8 != 0 || offset > size_ || count > (size_ - offset) / item_size) {
+			fail("section is out of the file"s);
+		}
+	};
+	check_section(header.documents_offset, header.document_count, sizeof(DocumentEntry));
+	check_section(header.terms_offset, header.term_count, sizeof(TermEntry));
+	check_section(header.hash_slots_offset, header.hash_slot_count, sizeof(uint32_t));
+	check_section(header.posting_ordinals_offset, header.posting_count, sizeof(int32_t));
+	check_section(header.posting_term_freqs_offset, header.posting_count, sizeof(double));
+	check_section(header.stop_words_offset, header.stop_word_count, sizeof(StringRef));
+	check_section(header.chars_offset, header.chars_size, 1);
+
+	const auto check_string = [&header, &fail](const StringRef& ref) {
+		if (ref.offset > header.chars_size || ref.size > header.chars_size - ref.offset) {
+			fail("string is out of the chars section"s);
+		}
+	};
+	const auto* terms = reinterpret_cast<const TermEntry*>(data_ + header.terms_offset);
+	const auto* posting_ordinals = reinterpret_cast<const int32_t*>(data_ + header.posting_ordinals_offset);
+	for (uint64_t index = 0; index < header.term_count; ++index) {
+		check_string(terms[index].term);
+		if (terms[index].postings_offset > header.posting_count
+			|| terms[index].postings_count > header.posting_count - terms[index].postings_offset) {
+			fail("posting list is out of the postings section"s);
+		}
+		if (check == Check::LAYOUT) {
+			continue;
+		}
+		// queries index the document table and dense arrays by these ordinals
+		const int32_t* ordinals = posting_ordinals + terms[index].postings_offset;
+		for (uint64_t i = 0; i < terms[index].postings_count; ++i) {
+			if (ordinals[i] < 0 || static_cast<uint64_t>(ordinals[i]) >= header.document_count
+				|| (i > 0 && ordinals[i] <= ordinals[i - 1])) {
+				fail("bad document ordinal in a posting list"s);
+			}
+		}
+	}
+	const auto* stop_words = reinterpret_cast<const StringRef*>(data_ + header.stop_words_offset);
+	for (uint64_t index = 0; index < header.stop_word_count; ++index) {
+		check_string(stop_words[index]);
+	}
+	// every term is in exactly one slot, so there are hash_slot_count - term_count
+	// empty slots and a lookup of an unknown term always stops
+	const auto* hash_slots = reinterpret_cast<const uint32_t*>(data_ + header.hash_slots_offset);
+	std::vector<bool> is_term_in_table(header.term_count, false);
+	for (uint64_t slot = 0; slot < header.hash_slot_count; ++slot) {
+		const uint32_t term_index = hash_slots[slot];
+		if (term_index == 0) {
+			continue;
+		}
+		if (term_index > header.term_count || is_term_in_table[term_index - 1]) {
+			fail("bad term index in the hash table"s);
+		}
+		is_term_in_table[term_index - 1] = true;
+	}
+	if (std::find(is_term_in_table.begin(), is_term_in_table.end(), false) != is_term_in_table.end()) {
+		fail("term is missing from the hash table"s);
+	}
+}
+
+std::string_view IndexSnapshot::GetString(const StringRef& ref) const
+{
+	return { chars_ + ref.offset, static_cast<size_t>(ref.size) };
+}
+
+bool IndexSnapshot::IsStopWord(std::string_view word) const
+{
+	const StringRef* end = stop_words_ + header_->stop_word_count;
+	const StringRef* it = std::lower_bound(stop_words_, end, word,
+		[this](const StringRef& ref, std::string_view value) {
+		return GetString(ref) < value;
+	});
+	return it != end && GetString(*it) == word;
+}
+
+const IndexSnapshot::TermEntry* IndexSnapshot::FindTerm(std::string_view word) const
+{
+	const uint64_t mask = header_->hash_slot_count - 1;
+	for (uint64_t slot = HashTerm(word) & mask;; slot = (slot + 1) & mask) {
+		const uint32_t term_index = hash_slots_[slot];
+		if (term_index == 0) {
+			return nullptr;
+		}
+		const TermEntry& term = terms_[term_index - 1];
+		if (GetString(term.term) == word) {
+			return &term;
+		}
+	}
+}
+
+int IndexSnapshot::FindOrdinal(int document_id) const
+{
+	const DocumentEntry* end = documents_ + header_->document_count;
+	const DocumentEntry* it = std::lower_bound(documents_, end, document_id,
+		[](const DocumentEntry& document, int value) {
+		return document.id < value;
+	});
+	if (it == end || it->id != document_id) {
+		return -1;
+	}
+	return static_cast<int>(it - documents_);
+}
+
+bool IndexSnapshot::ContainsOrdinal(const TermEntry& term, int ordinal) const
+{
+	const int32_t* begin = posting_ordinals_ + term.postings_offset;
+	return std::binary_search(begin, begin + term.postings_count, ordinal);
+}
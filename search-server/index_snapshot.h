@@ -0,0 +1,203 @@
+#pragma once
+#include "document.h"
+#include "query_parser.h"
+#include "search_server.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+// Read-only search index kept in a binary file. Save writes the state of a
+// SearchServer (stop words, document table, term dictionary and postings),
+// the constructor maps the file into memory and queries are answered right
+// from the mapped pages without building any containers.
+// A snapshot is readable only on a machine with the same byte order.
+// The layout and the hash table are checked on open, so a corrupt file is
+// rejected instead of being read out of bounds.
+class IndexSnapshot {
+public:
+	// What is checked on open besides the layout and the hash table, which
+	// take O(terms). FULL also checks every posting ordinal, which reads the
+	// whole postings section, O(index); LAYOUT skips it and is meant for
+	// files the application wrote itself, a bad ordinal is then read out of
+	// bounds by queries
+	enum class Check {
+		FULL,
+		LAYOUT,
+	};
+
+	static void Save(const SearchServer& search_server, const std::string& path);
+
+	// throws std::runtime_error if the file can't be mapped or has a wrong format
+	explicit IndexSnapshot(const std::string& path, Check check = Check::FULL);
+
+	IndexSnapshot(const IndexSnapshot&) = delete;
+	IndexSnapshot& operator=(const IndexSnapshot&) = delete;
+
+	IndexSnapshot(IndexSnapshot&& other) noexcept;
+
+	IndexSnapshot& operator=(IndexSnapshot&& other) noexcept;
+
+	~IndexSnapshot();
+
+	int GetDocumentCount() const;
+
+	template <typename DocumentPredicate>
+	std::vector<Document> FindTopDocuments(std::string_view raw_query,
+		DocumentPredicate document_predicate,
+		size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const;
+
+	std::vector<Document> FindTopDocuments(std::string_view raw_query,
+		DocumentStatus status = DocumentStatus::ACTUAL,
+		size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const;
+
+	std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(
+		std::string_view raw_query, int document_id) const;
+
+private:
+	static constexpr uint32_t VERSION = 1;
+	static constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+	// file layout: the header followed by 8-byte aligned sections
+	struct Header {
+		char magic[8];
+		uint32_t version;
+		uint32_t byte_order_mark;
+		uint64_t document_count;
+		uint64_t term_count;
+		uint64_t posting_count;
+		uint64_t stop_word_count;
+		uint64_t hash_slot_count;
+		uint64_t documents_offset;
+		uint64_t terms_offset;
+		uint64_t hash_slots_offset;
+		uint64_t posting_ordinals_offset;
+		uint64_t posting_term_freqs_offset;
+		uint64_t stop_words_offset;
+		uint64_t chars_offset;
+		uint64_t chars_size;
+	};
+
+	// documents are sorted by id, the position in the table is the ordinal
+	// used by the posting lists
+	struct DocumentEntry {
+		int32_t id;
+		int32_t rating;
+		int32_t status;
+		int32_t reserved;
+	};
+
+	// a string in the chars section
+	struct StringRef {
+		uint64_t offset;
+		uint64_t size;
+	};
+
+	struct TermEntry {
+		StringRef term;
+		uint64_t postings_offset;
+		uint64_t postings_count;
+	};
+
+	// stop words are sorted StringRefs, terms are found through an open
+	// addressed hash table of term indexes plus one, zero marks an empty slot
+	const char* data_ = nullptr;
+	size_t size_ = 0;
+	const Header* header_ = nullptr;
+	const DocumentEntry* documents_ = nullptr;
+	const TermEntry* terms_ = nullptr;
+	const uint32_t* hash_slots_ = nullptr;
+	const int32_t* posting_ordinals_ = nullptr;
+	const double* posting_term_freqs_ = nullptr;
+	const StringRef* stop_words_ = nullptr;
+	const char* chars_ = nullptr;
+
+	static uint64_t HashTerm(std::string_view term);
+
+	void Unmap();
+
+	void CheckLayout(Check check) const;
+
+	std::string_view GetString(const StringRef& ref) const;
+
+	bool IsStopWord(std::string_view word) const;
+
+	const TermEntry* FindTerm(std::string_view word) const;
+
+	// ordinal of the document or -1
+	int FindOrdinal(int document_id) const;
+
+	bool ContainsOrdinal(const TermEntry& term, int ordinal) const;
+
+	template <typename DocumentPredicate>
+	std::vector<Document> FindAllDocuments(std::string_view raw_query,
+		DocumentPredicate document_predicate) const;
+};
+
+// implementation templates
+template <typename DocumentPredicate>
+std::vector<Document> IndexSnapshot::FindTopDocuments(std::string_view raw_query,
+	DocumentPredicate document_predicate, size_t max_result_count) const
+{
+	auto matched_documents = FindAllDocuments(raw_query, document_predicate);
+	SearchServer::SelectTopDocuments(std::execution::seq, matched_documents, max_result_count);
+	return matched_documents;
+}
+
+template <typename DocumentPredicate>
+std::vector<Document> IndexSnapshot::FindAllDocuments(std::string_view raw_query,
+	DocumentPredicate document_predicate) const
+{
+	enum : char { UNSEEN, ACCEPTED, REJECTED };
+	const auto query = ParseQuery(raw_query, [this](std::string_view word) {
+		return IsStopWord(word);
+	});
+	const size_t document_count = header_->document_count;
+	// the same arithmetic as SearchServer
+	const double log_document_count = LogCount(document_count);
+	std::vector<double> relevance(document_count, 0.0);
+	std::vector<char> state(document_count, UNSEEN);
+
+	for (std::string_view word : query.minus_words) {
+		if (const TermEntry* term = FindTerm(word)) {
+			const int32_t* ordinals = posting_ordinals_ + term->postings_offset;
+			for (uint64_t i = 0; i < term->postings_count; ++i) {
+				state[ordinals[i]] = REJECTED;
+			}
+		}
+	}
+
+	for (std::string_view word : query.plus_words) {
+		const TermEntry* term = FindTerm(word);
+		if (term == nullptr || term->postings_count == 0) {
+			continue;
+		}
+		const double inverse_document_freq = ComputeInverseDocumentFreq(log_document_count,
+			LogCount(term->postings_count));
+		const int32_t* ordinals = posting_ordinals_ + term->postings_offset;
+		const double* term_freqs = posting_term_freqs_ + term->postings_offset;
+		for (uint64_t i = 0; i < term->postings_count; ++i) {
+			const int32_t ordinal = ordinals[i];
+			if (state[ordinal] == UNSEEN) {
+				const DocumentEntry& document = documents_[ordinal];
+				state[ordinal] = document_predicate(document.id,
+					static_cast<DocumentStatus>(document.status), document.rating)
+					? ACCEPTED : REJECTED;
+			}
+			if (state[ordinal] == ACCEPTED) {
+				relevance[ordinal] += term_freqs[i] * inverse_document_freq;
+			}
+		}
+	}
+
+	std::vector<Document> matched_documents;
+	for (size_t ordinal = 0; ordinal < document_count; ++ordinal) {
+		if (state[ordinal] == ACCEPTED) {
+			const DocumentEntry& document = documents_[ordinal];
+			matched_documents.push_back({ document.id, relevance[ordinal], document.rating });
+		}
+	}
+	return matched_documents;
+}
@@ -0,0 +1,342 @@
+#include "inverted_index.h"
+
+#include <algorithm>
+#include <cassert>
+
+PostingList::PostingList(std::pmr::memory_resource* resource)
+	: document_ids_(resource)
+	, term_freqs_(resource)
+{
+}
+
+size_t PostingList::size() const
+{
+	return compressed_ ? compressed_->size() : document_ids_.size();
+}
+
+bool PostingList::empty() const
+{
+	return size() == 0;
+}
+
+const std::pmr::vector<int>& PostingList::GetDocumentIds() const
+{
+	assert(!IsCompressed());
+	return document_ids_;
+}
+
+const std::pmr::vector<double>& PostingList::GetTermFreqs() const
+{
+	assert(!IsCompressed());
+	return term_freqs_;
+}
+
+bool PostingList::Contains(int document_id) const
+{
+	if (compressed_) {
+		return compressed_->Contains(document_id);
+	}
+	return std::binary_search(document_ids_.begin(), document_ids_.end(), document_id);
+}
+
+size_t PostingList::GetDocumentFreq() const
+{
+	return size() - deleted_count_;
+}
+
+double PostingList::GetLogDocumentFreq() const
+{
+	return log_document_freq_;
+}
+
+double PostingList::GetMaxTermFreq() const
+{
+	return max_term_freq_;
+}
+
+size_t PostingList::GetByteSize() const
+{
+	size_t bytes = document_ids_.capacity() * sizeof(int) + term_freqs_.capacity() * sizeof(double);
+	if (compressed_) {
+		bytes += sizeof(CompressedPostings) + compressed_->GetByteSize();
+	}
+	return bytes;
+}
+
+void PostingList::AddTermFreq(int document_id, double term_freq)
+{
+	Decompress();
+	// documents usually come in ascending order, so the common case is an append
+	if (document_ids_.empty() || document_ids_.back() < document_id) {
+		document_ids_.push_back(document_id);
+		term_freqs_.push_back(term_freq);
+		max_term_freq_ = std::max(max_term_freq_, term_freq);
+		UpdateLogDocumentFreq();
+		return;
+	}
+	const auto it = std::lower_bound(document_ids_.begin(), document_ids_.end(), document_id);
+	const auto pos = it - document_ids_.begin();
+	if (it != document_ids_.end() && *it == document_id) {
+		term_freqs_[pos] += term_freq;
+		max_term_freq_ = std::max(max_term_freq_, term_freqs_[pos]);
+	}
+	else {
+		document_ids_.insert(it, document_id);
+		term_freqs_.insert(term_freqs_.begin() + pos, term_freq);
+		max_term_freq_ = std::max(max_term_freq_, term_freq);
+		UpdateLogDocumentFreq();
+	}
+}
+
+bool PostingList::Erase(int document_id)
+{
+	Decompress();
+	const auto it = std::lower_bound(document_ids_.begin(), document_ids_.end(), document_id);
+	if (it == document_ids_.end() || *it != document_id) {
+		return false;
+	}
+	term_freqs_.erase(term_freqs_.begin() + (it - document_ids_.begin()));
+	document_ids_.erase(it);
+	UpdateLogDocumentFreq();
+	return true;
+}
+
+size_t PostingList::EraseDocuments(const std::vector<bool>& is_erased)
+{
+	Decompress();
+	size_t kept_count = 0;
+	for (size_t i = 0; i < document_ids_.size(); ++i) {
+		const int document_id = document_ids_[i];
+		if (static_cast<size_t>(document_id) < is_erased.size() && is_erased[document_id]) {
+			continue;
+		}
+		document_ids_[kept_count] = document_id;
+		term_freqs_[kept_count] = term_freqs_[i];
+		++kept_count;
+	}
+	const size_t erased_count = document_ids_.size() - kept_count;
+	if (erased_count > 0) {
+		document_ids_.resize(kept_count);
+		term_freqs_.resize(kept_count);
+		UpdateLogDocumentFreq();
+		UpdateMaxTermFreq();
+	}
+	return erased_count;
+}
+
+void PostingList::MarkDeleted(size_t document_count)
+{
+	deleted_count_ += document_count;
+	UpdateLogDocumentFreq();
+}
+
+PostingList PostingList::WithoutDocuments(const std::vector<bool>& is_erased) const
+{
+	PostingList result;
+	// runs concurrently with MarkDeleted, so the deleted count is not read
+	result.document_ids_.reserve(size());
+	result.term_freqs_.reserve(size());
+	ForEach([&is_erased, &result](int document_id, double term_freq) {
+		if (static_cast<size_t>(document_id) >= is_erased.size() || !is_erased[document_id]) {
+			result.document_ids_.push_back(document_id);
+			result.term_freqs_.push_back(term_freq);
+		}
+	});
+	result.UpdateMaxTermFreq();
+	return result;
+}
+
+void PostingList::ApplyCompaction(PostingList&& compacted)
+{
+	// documents marked deleted after the copy was made are still in it
+	deleted_count_ -= size() - compacted.size();
+	const bool is_compressed = IsCompressed();
+	// arrays from another memory resource are copied into the own one
+	document_ids_ = std::move(compacted.document_ids_);
+	term_freqs_ = std::move(compacted.term_freqs_);
+	max_term_freq_ = compacted.max_term_freq_;
+	compressed_.reset();
+	if (is_compressed) {
+		Compress();
+	}
+}
+
+void PostingList::Compress()
+{
+	if (compressed_) {
+		return;
+	}
+	std::pmr::memory_resource* resource = document_ids_.get_allocator().resource();
+	std::pmr::polymorphic_allocator<CompressedPostings> allocator(resource);
+	CompressedPostings* block = allocator.allocate(1);
+	try {
+		allocator.construct(block, document_ids_, term_freqs_, resource);
+	}
+	catch (...) {
+		allocator.deallocate(block, 1);
+		throw;
+	}
+	std::unique_ptr<CompressedPostings, CompressedPostingsDeleter> compressed(block, { resource });
+	// a list with many distinct term frequencies may take more space compressed
+	if (compressed->GetByteSize() >= document_ids_.size() * (sizeof(int) + sizeof(double))) {
+		return;
+	}
+	compressed_ = std::move(compressed);
+	// clear() alone would keep the memory
+	document_ids_.clear();
+	document_ids_.shrink_to_fit();
+	term_freqs_.clear();
+	term_freqs_.shrink_to_fit();
+}
+
+bool PostingList::IsCompressed() const
+{
+	return compressed_ != nullptr;
+}
+
+void PostingList::Decompress()
+{
+	if (!compressed_) {
+		return;
+	}
+	compressed_->Decode(document_ids_, term_freqs_);
+	compressed_.reset();
+}
+
+void CompressedPostingsDeleter::operator()(CompressedPostings* compressed) const
+{
+	std::pmr::polymorphic_allocator<CompressedPostings> allocator(resource);
+	compressed->~CompressedPostings();
+	allocator.deallocate(compressed, 1);
+}
+
+void PostingList::UpdateMaxTermFreq()
+{
+	max_term_freq_ = term_freqs_.empty() ? 0.0 : *std::max_element(term_freqs_.begin(), term_freqs_.end());
+}
+
+void PostingList::UpdateLogDocumentFreq()
+{
+	log_document_freq_ = LogCount(GetDocumentFreq());
+}
+
+PostingCursor::PostingCursor(const PostingList& postings)
+	: compressed_(postings.compressed_.get())
+{
+	if (compressed_ == nullptr) {
+		document_ids_ = postings.document_ids_.data();
+		term_freqs_ = postings.term_freqs_.data();
+		size_ = postings.document_ids_.size();
+	}
+	else {
+		block_document_ids_.resize(CompressedPostings::BLOCK_SIZE);
+		block_term_freqs_.resize(CompressedPostings::BLOCK_SIZE);
+		document_ids_ = block_document_ids_.data();
+		term_freqs_ = block_term_freqs_.data();
+		LoadBlock(0);
+	}
+}
+
+void PostingCursor::Advance(int document_id)
+{
+	if (IsEnd() || GetDocumentId() >= document_id) {
+		return;
+	}
+	if (compressed_ != nullptr && document_ids_[size_ - 1] < document_id) {
+		// the target is in a later block, the blocks between are skipped
+		LoadBlock(std::max(block_ + 1, compressed_->FindBlock(document_id)));
+		if (IsEnd()) {
+			return;
+		}
+	}
+	position_ = std::lower_bound(document_ids_ + position_, document_ids_ + size_, document_id)
+		- document_ids_;
+	if (position_ == size_ && compressed_ != nullptr) {
+		LoadBlock(block_ + 1);
+	}
+}
+
+void PostingCursor::LoadBlock(size_t block)
+{
+	block_ = block;
+	position_ = 0;
+	size_ = block < compressed_->GetBlockCount()
+		? compressed_->DecodeBlock(block, block_document_ids_.data(), block_term_freqs_.data())
+		: 0;
+}
+
+InvertedIndex::InvertedIndex(std::pmr::memory_resource* resource)
+	: terms_(resource)
+	, postings_(resource)
+{
+}
+
+const PostingList* InvertedIndex::Find(std::string_view word) const
+{
+	const uint32_t term_id = terms_.Find(word);
+	return term_id == TermPool::NO_TERM ? nullptr : &postings_[term_id];
+}
+
+PostingList* InvertedIndex::Find(std::string_view word)
+{
+	const uint32_t term_id = terms_.Find(word);
+	return term_id == TermPool::NO_TERM ? nullptr : &postings_[term_id];
+}
+
+std::pair<std::string_view, PostingList*> InvertedIndex::FindTerm(std::string_view word)
+{
+	const uint32_t term_id = terms_.Find(word);
+	if (term_id == TermPool::NO_TERM) {
+		return { word, nullptr };
+	}
+	return { terms_.GetTerm(term_id), &postings_[term_id] };
+}
+
+std::pair<std::string_view, PostingList&> InvertedIndex::Insert(std::string_view word)
+{
+	const uint32_t term_id = terms_.Intern(word);
+	if (term_id == postings_.size()) {
+		postings_.emplace_back(postings_.get_allocator().resource());
+	}
+	return { terms_.GetTerm(term_id), postings_[term_id] };
+}
+
+uint32_t InvertedIndex::FindTermId(std::string_view word) const
+{
+	return terms_.Find(word);
+}
+
+size_t InvertedIndex::GetTermCount() const
+{
+	return postings_.size();
+}
+
+std::string_view InvertedIndex::GetTerm(uint32_t term_id) const
+{
+	return terms_.GetTerm(term_id);
+}
+
+const PostingList& InvertedIndex::GetPostings(uint32_t term_id) const
+{
+	return postings_[term_id];
+}
+
+PostingList& InvertedIndex::GetPostings(uint32_t term_id)
+{
+	return postings_[term_id];
+}
+
+MemoryUsage InvertedIndex::GetDictionaryMemoryUsage() const
+{
+	return { terms_.GetByteSize() + postings_.size() * sizeof(PostingList), terms_.size() };
+}
+
+MemoryUsage InvertedIndex::GetPostingsMemoryUsage() const
+{
+	MemoryUsage usage;
+	for (const PostingList& postings : postings_) {
+		usage.bytes += postings.GetByteSize();
+		usage.count += postings.size();
+	}
+	return usage;
+}
@@ -0,0 +1,232 @@
+#pragma once
+#include "compressed_postings.h"
+#include "memory_stats.h"
+#include "term_pool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <memory>
+#include <memory_resource>
+#include <string_view>
+#include <vector>
+
+// idf of a term is log(N / df), computed as log(N) - log(df) by every index
+// from these two functions, so their relevances agree bit for bit
+inline double LogCount(size_t count)
+{
+	return count == 0 ? 0.0 : std::log(static_cast<double>(count));
+}
+
+inline double ComputeInverseDocumentFreq(double log_document_count, double log_document_freq)
+{
+	return log_document_count - log_document_freq;
+}
+
+// destroys compressed postings allocated from the resource
+struct CompressedPostingsDeleter {
+	std::pmr::memory_resource* resource = nullptr;
+
+	void operator()(CompressedPostings* compressed) const;
+};
+
+// Postings of a single term: document ids sorted in ascending order
+// and term frequencies stored in a parallel array. The logarithm of the
+// document frequency is kept up to date on every change, so scoring
+// never calls log() for the term.
+// Documents may be marked deleted without rewriting the list: they stay in
+// the arrays but are excluded from the document frequency until the list
+// is compacted.
+// A list may be compressed to save memory. Reads work on both forms through
+// ForEach and ForEachInRange; any change except MarkDeleted decodes the list
+// back to the plain arrays first
+class PostingList {
+	friend class PostingCursor;
+
+public:
+	explicit PostingList(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+	// number of stored documents, the deleted ones included
+	size_t size() const;
+
+	bool empty() const;
+
+	// the plain arrays, the list must not be compressed
+	const std::pmr::vector<int>& GetDocumentIds() const;
+
+	const std::pmr::vector<double>& GetTermFreqs() const;
+
+	// calls visitor(document_id, term_freq) for every posting, ids ascending
+	template <typename Visitor>
+	void ForEach(Visitor visitor) const
+	{
+		if (compressed_) {
+			compressed_->ForEach(visitor);
+			return;
+		}
+		for (size_t i = 0; i < document_ids_.size(); ++i) {
+			visitor(document_ids_[i], term_freqs_[i]);
+		}
+	}
+
+	// the same for the postings with first_id <= document id < last_id
+	template <typename Visitor>
+	void ForEachInRange(int first_id, int last_id, Visitor visitor) const
+	{
+		if (compressed_) {
+			compressed_->ForEachInRange(first_id, last_id, visitor);
+			return;
+		}
+		size_t i = std::lower_bound(document_ids_.begin(), document_ids_.end(), first_id)
+			- document_ids_.begin();
+		for (; i < document_ids_.size() && document_ids_[i] < last_id; ++i) {
+			visitor(document_ids_[i], term_freqs_[i]);
+		}
+	}
+
+	bool Contains(int document_id) const;
+
+	// number of documents which are not marked deleted
+	size_t GetDocumentFreq() const;
+
+	double GetLogDocumentFreq() const;
+
+	// upper bound of the term frequencies in the list
+	double GetMaxTermFreq() const;
+
+	// heap bytes of the postings in either form
+	size_t GetByteSize() const;
+
+	void AddTermFreq(int document_id, double term_freq);
+
+	bool Erase(int document_id);
+
+	// erases every document whose is_erased flag is set in a single pass,
+	// returns the number of erased documents
+	size_t EraseDocuments(const std::vector<bool>& is_erased);
+
+	void MarkDeleted(size_t document_count);
+
+	// copy of the list without the documents whose is_erased flag is set;
+	// the flagged documents must be marked deleted. The copy is built by the
+	// background compaction, so it takes memory from the default resource
+	PostingList WithoutDocuments(const std::vector<bool>& is_erased) const;
+
+	// replaces the contents by a list built with WithoutDocuments
+	// from the current contents, a compressed list stays compressed
+	void ApplyCompaction(PostingList&& compacted);
+
+	// replaces the plain arrays by the compressed form,
+	// unless the compressed form is not smaller
+	void Compress();
+
+	bool IsCompressed() const;
+
+private:
+	std::pmr::vector<int> document_ids_;
+	std::pmr::vector<double> term_freqs_;
+
+	// set instead of the arrays while the list is compressed,
+	// allocated from the memory resource of the arrays
+	std::unique_ptr<CompressedPostings, CompressedPostingsDeleter> compressed_;
+	size_t deleted_count_ = 0;
+	double log_document_freq_ = 0.0;
+	// not lowered by Erase, it is recomputed when the whole list is rewritten
+	double max_term_freq_ = 0.0;
+
+	void Decompress();
+
+	void UpdateMaxTermFreq();
+
+	void UpdateLogDocumentFreq();
+};
+
+// Forward iterator over a posting list in either form which can skip ahead;
+// a compressed list is decoded one block at a time and only blocks which
+// may hold the target of Advance are decoded.
+// The list must not change while the cursor is in use
+class PostingCursor {
+public:
+	explicit PostingCursor(const PostingList& postings);
+
+	bool IsEnd() const
+	{
+		return position_ == size_;
+	}
+
+	int GetDocumentId() const
+	{
+		return document_ids_[position_];
+	}
+
+	double GetTermFreq() const
+	{
+		return term_freqs_[position_];
+	}
+
+	void Next()
+	{
+		if (++position_ == size_ && compressed_ != nullptr) {
+			LoadBlock(block_ + 1);
+		}
+	}
+
+	// moves to the first posting with id not less than document_id
+	void Advance(int document_id);
+
+private:
+	const CompressedPostings* compressed_ = nullptr;
+	size_t block_ = 0;
+	// the whole plain list or the current block of a compressed one
+	const int* document_ids_ = nullptr;
+	const double* term_freqs_ = nullptr;
+	size_t size_ = 0;
+	size_t position_ = 0;
+	std::vector<int> block_document_ids_;
+	std::vector<double> block_term_freqs_;
+
+	void LoadBlock(size_t block);
+};
+
+// Term dictionary in front of the posting lists.
+// Terms are interned in a pool and numbered by dense ids, the posting list
+// of a term is addressed by its id. Terms stay valid after the document
+// which introduced them is removed, and posting lists never move
+class InvertedIndex {
+public:
+	// the dictionary and the posting lists take memory from the resource
+	explicit InvertedIndex(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+	const PostingList* Find(std::string_view word) const;
+
+	PostingList* Find(std::string_view word);
+
+	// returns the term stored in the index and its posting list,
+	// the list is null if the term is unknown
+	std::pair<std::string_view, PostingList*> FindTerm(std::string_view word);
+
+	// returns the term stored in the index and its posting list
+	std::pair<std::string_view, PostingList&> Insert(std::string_view word);
+
+	// id of the term or TermPool::NO_TERM
+	uint32_t FindTermId(std::string_view word) const;
+
+	// terms have ids from zero to GetTermCount() - 1
+	size_t GetTermCount() const;
+
+	std::string_view GetTerm(uint32_t term_id) const;
+
+	const PostingList& GetPostings(uint32_t term_id) const;
+
+	PostingList& GetPostings(uint32_t term_id);
+
+	// the terms and the posting list headers
+	MemoryUsage GetDictionaryMemoryUsage() const;
+
+	MemoryUsage GetPostingsMemoryUsage() const;
+
+private:
+	TermPool terms_;
+	// indexed by term id
+	std::pmr::deque<PostingList> postings_;
+};
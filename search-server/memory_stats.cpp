@@ -0,0 +1,14 @@
+#include "memory_stats.h"
+
+size_t SearchServerMemoryStats::GetTotalBytes() const
+{
+	return term_dictionary.bytes + postings.bytes + forward_index.bytes + documents.bytes
+		+ document_texts.bytes + stop_words.bytes + query_cache.bytes;
+}
+
+size_t GetStringHeapBytes(const std::string& text)
+{
+	const char* object_begin = reinterpret_cast<const char*>(&text);
+	const bool is_inside = text.data() >= object_begin && text.data() < object_begin + sizeof(text);
+	return is_inside ? 0 : text.capacity() + 1;
+}
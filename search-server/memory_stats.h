@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+// Heap memory taken by one structure and the number of its elements.
+// Node based containers are estimated by the usual node layout: a tree node
+// holds three links and a color, a hash node a link and the cached hash
+struct MemoryUsage {
+	size_t bytes = 0;
+	size_t count = 0;
+};
+
+struct SearchServerMemoryStats {
+	// interned terms, their hash table and the posting list headers,
+	// counted in terms
+	MemoryUsage term_dictionary;
+	// posting arrays, plain or compressed, counted in postings
+	MemoryUsage postings;
+	// counted in (document, word) entries
+	MemoryUsage forward_index;
+	// document table, id map and id set, counted in documents
+	MemoryUsage documents;
+	// text arena, counted in documents ever added
+	MemoryUsage document_texts;
+	MemoryUsage stop_words;
+	// counted in cached searches
+	MemoryUsage query_cache;
+
+	size_t GetTotalBytes() const;
+};
+
+template <typename TreeContainer>
+size_t EstimateTreeBytes(const TreeContainer& container)
+{
+	return container.size() * (4 * sizeof(void*) + sizeof(typename TreeContainer::value_type));
+}
+
+template <typename HashContainer>
+size_t EstimateHashBytes(const HashContainer& container)
+{
+	return container.bucket_count() * sizeof(void*)
+		+ container.size() * (2 * sizeof(void*) + sizeof(typename HashContainer::value_type));
+}
+
+// zero for a string kept in the object itself
+size_t GetStringHeapBytes(const std::string& text);
@@ -0,0 +1,48 @@
+#include "process_queries.h"
+
+#include <algorithm>
+#include <execution>
+#include <numeric>
+
+std::vector<std::vector<Document>> ProcessQueries(
+	const SearchServer& search_server,
+	const std::vector<std::string>& queries)
+{
+	std::vector<std::vector<Document>> documents_lists(queries.size());
+	std::transform(std::execution::par,
+		queries.begin(), queries.end(), documents_lists.begin(),
+		[&search_server](const std::string& query) {
+		return search_server.FindTopDocuments(query);
+	});
+	return documents_lists;
+}
+
+std::vector<Document> ProcessQueriesJoined(
+	const SearchServer& search_server,
+	const std::vector<std::string>& queries)
+{
+	// every query writes into its own fixed-size slot of the joined vector,
+	// then the slots are packed together, so no vector of vectors is built
+	std::vector<Document> documents(queries.size() * MAX_RESULT_DOCUMENT_COUNT);
+	std::vector<size_t> counts(queries.size());
+	std::vector<size_t> query_indexes(queries.size());
+	std::iota(query_indexes.begin(), query_indexes.end(), 0);
+
+	std::for_each(std::execution::par,
+		query_indexes.begin(), query_indexes.end(),
+		[&search_server, &queries, &documents, &counts](size_t index) {
+		const auto result = search_server.FindTopDocuments(queries[index]);
+		std::copy(result.begin(), result.end(),
+			documents.begin() + index * MAX_RESULT_DOCUMENT_COUNT);
+		counts[index] = result.size();
+	});
+
+	size_t joined_count = 0;
+	for (size_t index = 0; index < queries.size(); ++index) {
+		const auto slot_begin = documents.begin() + index * MAX_RESULT_DOCUMENT_COUNT;
+		std::move(slot_begin, slot_begin + counts[index], documents.begin() + joined_count);
+		joined_count += counts[index];
+	}
+	documents.resize(joined_count);
+	return documents;
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include "search_server.h"
+
+#include <string>
+#include <vector>
+
+// Runs FindTopDocuments for every query, queries are processed in parallel
+std::vector<std::vector<Document>> ProcessQueries(
+	const SearchServer& search_server,
+	const std::vector<std::string>& queries);
+
+// Same as ProcessQueries, but the results of all queries are returned
+// one after another in a single flat vector
+std::vector<Document> ProcessQueriesJoined(
+	const SearchServer& search_server,
+	const std::vector<std::string>& queries);
@@ -0,0 +1,107 @@
+#include "query_cache.h"
+
+#include <functional>
+#include <stdexcept>
+
+using std::string_literals::operator""s;
+
+bool QueryCache::Key::operator==(const Key& other) const
+{
+	return words == other.words
+		&& predicate.type == other.predicate.type
+		&& predicate.status == other.predicate.status
+		&& max_result_count == other.max_result_count;
+}
+
+size_t QueryCache::KeyHash::operator()(const Key& key) const
+{
+	size_t hash = std::hash<std::string>{}(key.words);
+	hash = hash * 37 + key.predicate.type.hash_code();
+	hash = hash * 37 + static_cast<size_t>(key.predicate.status);
+	return hash * 37 + key.max_result_count;
+}
+
+QueryCache::QueryCache(size_t capacity)
+	: capacity_(capacity)
+{
+	if (capacity_ == 0) {
+		throw std::invalid_argument("Query cache capacity must be positive"s);
+	}
+}
+
+QueryCache::Key QueryCache::MakeKey(const Query& query, const PredicateKey& predicate,
+	size_t max_result_count)
+{
+	// words contain neither spaces nor control characters,
+	// so the separators can't be confused with them
+	Key key{ {}, predicate, max_result_count };
+	for (std::string_view word : query.plus_words) {
+		key.words.append(word).push_back(' ');
+	}
+	key.words.push_back('\0');
+	for (std::string_view word : query.minus_words) {
+		key.words.append(word).push_back(' ');
+	}
+	return key;
+}
+
+std::optional<std::vector<Document>> QueryCache::Find(const Key& key, uint64_t generation)
+{
+	std::lock_guard guard(mutex_);
+	SetGeneration(generation);
+	const auto it = entries_.find(key);
+	if (it == entries_.end()) {
+		return std::nullopt;
+	}
+	recent_keys_.splice(recent_keys_.begin(), recent_keys_, it->second.position);
+	return it->second.documents;
+}
+
+void QueryCache::Insert(Key key, uint64_t generation, std::vector<Document> documents)
+{
+	std::lock_guard guard(mutex_);
+	SetGeneration(generation);
+	auto [it, inserted] = entries_.try_emplace(std::move(key));
+	it->second.documents = std::move(documents);
+	if (!inserted) {
+		recent_keys_.splice(recent_keys_.begin(), recent_keys_, it->second.position);
+		return;
+	}
+	recent_keys_.push_front(&it->first);
+	it->second.position = recent_keys_.begin();
+	if (entries_.size() > capacity_) {
+		entries_.erase(entries_.find(*recent_keys_.back()));
+		recent_keys_.pop_back();
+	}
+}
+
+size_t QueryCache::GetCapacity() const
+{
+	return capacity_;
+}
+
+size_t QueryCache::size() const
+{
+	std::lock_guard guard(mutex_);
+	return entries_.size();
+}
+
+MemoryUsage QueryCache::GetMemoryUsage() const
+{
+	std::lock_guard guard(mutex_);
+	MemoryUsage usage{ EstimateHashBytes(entries_), entries_.size() };
+	usage.bytes += recent_keys_.size() * (2 * sizeof(void*) + sizeof(const Key*));
+	for (const auto& [key, entry] : entries_) {
+		usage.bytes += GetStringHeapBytes(key.words) + entry.documents.capacity() * sizeof(Document);
+	}
+	return usage;
+}
+
+void QueryCache::SetGeneration(uint64_t generation)
+{
+	if (generation != generation_) {
+		entries_.clear();
+		recent_keys_.clear();
+		generation_ = generation;
+	}
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include "document.h"
+#include "memory_stats.h"
+#include "query_parser.h"
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+
+// Bounded LRU cache of search results. Entries belong to a generation of the
+// index: the owner bumps the generation on every change of the documents and
+// the first access with a new generation drops all entries at once.
+// Safe to use from several threads.
+class QueryCache {
+public:
+	// identifies the document filter of a search: the status for status
+	// searches, the type of a predicate marked cacheable otherwise
+	struct PredicateKey {
+		std::type_index type;
+		int status = -1;
+	};
+
+	struct Key {
+		// sorted unique plus words and minus words of the parsed query
+		std::string words;
+		PredicateKey predicate;
+		size_t max_result_count = 0;
+
+		bool operator==(const Key& other) const;
+	};
+
+	explicit QueryCache(size_t capacity);
+
+	static Key MakeKey(const Query& query, const PredicateKey& predicate,
+		size_t max_result_count);
+
+	std::optional<std::vector<Document>> Find(const Key& key, uint64_t generation);
+
+	void Insert(Key key, uint64_t generation, std::vector<Document> documents);
+
+	size_t GetCapacity() const;
+
+	size_t size() const;
+
+	// the keys, the results and estimated table and list nodes
+	MemoryUsage GetMemoryUsage() const;
+
+private:
+	struct KeyHash {
+		size_t operator()(const Key& key) const;
+	};
+
+	struct Entry {
+		std::vector<Document> documents;
+		// position in recent_keys_
+		std::list<const Key*>::iterator position;
+	};
+
+	mutable std::mutex mutex_;
+	const size_t capacity_;
+	uint64_t generation_ = 0;
+	std::unordered_map<Key, Entry, KeyHash> entries_;
+	// keys of entries_, the most recently used first
+	std::list<const Key*> recent_keys_;
+
+	// the mutex must be locked
+	void SetGeneration(uint64_t generation);
+};
@@ -0,0 +1,24 @@
+#include "query_parser.h"
+
+#include <stdexcept>
+#include <string>
+
+using std::string_literals::operator""s;
+
+QueryWord ParseQueryWord(std::string_view text)
+{
+	if (text.empty()) {
+		throw std::invalid_argument("Query word is empty"s);
+	}
+	std::string_view word = text;
+	bool is_minus = false;
+	if (word[0] == '-') {
+		is_minus = true;
+		word = word.substr(1);
+	}
+	if (word.empty() || word[0] == '-' || ContainsControlChars(word)) {
+		throw std::invalid_argument("Query word "s + std::string(word) + " is invalid"s);
+	}
+
+	return { word, is_minus };
+}
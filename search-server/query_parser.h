@@ -0,0 +1,60 @@
+#pragma once
+#include "string_processing.h"
+
+#include <algorithm>
+#include <string_view>
+#include <vector>
+
+struct Query {
+	std::vector<std::string_view> plus_words;
+	std::vector<std::string_view> minus_words;
+};
+
+struct QueryWord {
+	std::string_view data;
+	bool is_minus;
+};
+
+// Throws std::invalid_argument if the word is empty, starts with "--"
+// or contains control characters
+QueryWord ParseQueryWord(std::string_view text);
+
+// Splits a raw query into plus and minus words, dropping the words for which
+// is_stop_word returns true. With remove_duplicates both lists are sorted
+// and contain every word once. Words are views into text
+template <typename StopWordPredicate>
+Query ParseQuery(std::string_view text, StopWordPredicate is_stop_word,
+	bool remove_duplicates = true)
+{
+	Query result;
+	for (std::string_view word : SplitIntoWords(text)) {
+		const auto query_word = ParseQueryWord(word);
+		if (!is_stop_word(query_word.data)) {
+			if (query_word.is_minus) {
+				result.minus_words.push_back(query_word.data);
+			}
+			else {
+				result.plus_words.push_back(query_word.data);
+			}
+		}
+	}
+	if (!remove_duplicates) {
+		return result;
+	}
+	// make sort for minus and plus words
+	std::sort(result.minus_words.begin(), result.minus_words.end());
+	std::sort(result.plus_words.begin(), result.plus_words.end());
+
+	// apply std::unique which remove consequitive equal elements
+	auto last_minus = std::unique(result.minus_words.begin(), result.minus_words.end());
+	auto last_plus = std::unique(result.plus_words.begin(), result.plus_words.end());
+
+	// resize vectors by new size
+	size_t newSize = last_minus - result.minus_words.begin();
+	result.minus_words.resize(newSize);
+
+	newSize = last_plus - result.plus_words.begin();
+	result.plus_words.resize(newSize);
+
+	return result;
+}
@@ -1,7 +1,7 @@
-#pragma once
-#include <string>
-#include <iostream>
-
-std::string ReadLine();
-
+#pragma once
+#include <string>
+#include <iostream>
+
+std::string ReadLine();
+
 int ReadLineWithNumber();
\ No newline at end of file
@@ -1,30 +1,212 @@
-#include "search_server.h"
-#include "remove_duplicates.h"
-
-#include <iterator>
-
-void RemoveDuplicates(SearchServer & search_server)
-{
-	std::set<int> duplicateID;
-	std::set<std::set<std::string>> comparingWord;
-	
-	for (const auto& document_id : search_server) {
-		std::set<std::string> duplicateWord;
-		const std::map<std::string, double>& bufferData = search_server.GetWordFrequencies(document_id);		std::transform(bufferData.cbegin(), bufferData.cend(),
-			std::inserter(duplicateWord, duplicateWord.begin()),
-			[](const std::pair<std::string, double>& key_value)
-		{ return key_value.first; });
-
-		if (!comparingWord.count(duplicateWord)) {
-			comparingWord.insert(duplicateWord);
-		}
-		else {
-			duplicateID.insert(document_id);
-		}
-	}
-
-	for (auto id : duplicateID) {
-			std::cout << "Found duplicate document id " << id << std::endl;
-			search_server.RemoveDocument(id);
-		}
-}
\ No newline at end of file
+#include "search_server.h"
+#include "remove_duplicates.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <execution>
+#include <numeric>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+namespace {
+
+struct Fingerprint {
+	// hash of the sorted word set
+	std::pair<uint64_t, uint64_t> words_hash;
+	uint64_t simhash = 0;
+};
+
+uint64_t Mix(uint64_t hash)
+{
+	hash ^= hash >> 33;
+	hash *= 0xff51afd7ed558ccdULL;
+	hash ^= hash >> 33;
+	hash *= 0xc4ceb9fe1a85ec53ULL;
+	hash ^= hash >> 33;
+	return hash;
+}
+
+uint64_t HashWord(std::string_view word, uint64_t seed)
+{
+	uint64_t hash = 14695981039346656037ULL ^ seed;
+	for (const char c : word) {
+		hash ^= static_cast<unsigned char>(c);
+		hash *= 1099511628211ULL;
+	}
+	return Mix(hash);
+}
+
+Fingerprint ComputeFingerprint(const std::pmr::map<std::string_view, double>& word_freqs)
+{
+	Fingerprint result{ { 0, 0 }, 0 };
+	std::array<double, 64> weights{};
+	// words come sorted, so an order dependent combination
+	// identifies the set
+	for (const auto& [word, term_freq] : word_freqs) {
+		const uint64_t first_hash = HashWord(word, 0);
+		const uint64_t second_hash = HashWord(word, 0x9E3779B97F4A7C15ULL);
+		result.words_hash.first = Mix(result.words_hash.first ^ first_hash) + 1;
+		result.words_hash.second = Mix(result.words_hash.second + second_hash) ^ 1;
+		for (int bit = 0; bit < 64; ++bit) {
+			weights[bit] += (first_hash >> bit & 1) ? term_freq : -term_freq;
+		}
+	}
+	for (int bit = 0; bit < 64; ++bit) {
+		if (weights[bit] > 0.0) {
+			result.simhash |= uint64_t{ 1 } << bit;
+		}
+	}
+	return result;
+}
+
+// calls visitor with the word frequencies of the document: the stored ones
+// in the FULL forward index mode, a copy in the other modes, so a scan of
+// the whole server does not make it keep a map per document
+template <typename Visitor>
+auto VisitWordFrequencies(const SearchServer& search_server, int document_id, Visitor visitor)
+{
+	if (search_server.GetForwardIndexMode() == ForwardIndexMode::FULL) {
+		return visitor(search_server.GetWordFrequencies(document_id));
+	}
+	return visitor(search_server.GetWordFrequenciesCopy(document_id));
+}
+
+std::vector<std::string_view> GetDocumentWords(const SearchServer& search_server, int document_id)
+{
+	return VisitWordFrequencies(search_server, document_id,
+		[](const std::pmr::map<std::string_view, double>& word_freqs) {
+		std::vector<std::string_view> words;
+		words.reserve(word_freqs.size());
+		for (const auto& [word, term_freq] : word_freqs) {
+			words.push_back(word);
+		}
+		return words;
+	});
+}
+
+int CountBits(uint64_t value)
+{
+	int count = 0;
+	for (; value != 0; value &= value - 1) {
+		++count;
+	}
+	return count;
+}
+
+// Fingerprints within max_distance bits agree exactly on at least one of
+// max_distance + 1 disjoint blocks, so only documents sharing a block value
+// are compared. Returns indexes of documents near to a document with a
+// smaller index
+std::vector<size_t> FindNearDuplicates(const std::vector<Fingerprint>& fingerprints, int max_distance)
+{
+	const int block_count = max_distance + 1;
+	std::vector<int> blocks(block_count);
+	std::iota(blocks.begin(), blocks.end(), 0);
+	std::vector<std::vector<size_t>> block_duplicates(block_count);
+	std::for_each(std::execution::par, blocks.begin(), blocks.end(),
+		[&fingerprints, &block_duplicates, block_count, max_distance](int block) {
+		const int first_bit = 64 * block / block_count;
+		const int last_bit = 64 * (block + 1) / block_count;
+		const uint64_t mask = (last_bit - first_bit == 64)
+			? ~uint64_t{ 0 } : ((uint64_t{ 1 } << (last_bit - first_bit)) - 1) << first_bit;
+
+		std::vector<std::pair<uint64_t, size_t>> keys(fingerprints.size());
+		for (size_t index = 0; index < fingerprints.size(); ++index) {
+			keys[index] = { fingerprints[index].simhash & mask, index };
+		}
+		std::sort(keys.begin(), keys.end());
+		auto& duplicates = block_duplicates[block];
+		for (auto group_begin = keys.begin(); group_begin != keys.end();) {
+			const auto group_end = std::find_if(group_begin, keys.end(),
+				[group_begin](const auto& key) { return key.first != group_begin->first; });
+			// indexes inside a group are ascending
+			for (auto it = group_begin + 1; it < group_end; ++it) {
+				const uint64_t simhash = fingerprints[it->second].simhash;
+				if (std::any_of(group_begin, it, [&fingerprints, simhash, max_distance](const auto& key) {
+					return CountBits(fingerprints[key.second].simhash ^ simhash) <= max_distance;
+				})) {
+					duplicates.push_back(it->second);
+				}
+			}
+			group_begin = group_end;
+		}
+	});
+
+	std::vector<size_t> result;
+	for (const auto& duplicates : block_duplicates) {
+		result.insert(result.end(), duplicates.begin(), duplicates.end());
+	}
+	return result;
+}
+
+}  // namespace
+
+std::vector<int> FindDuplicates(const SearchServer& search_server,
+	const DuplicateSearchOptions& options)
+{
+	if (options.find_near_duplicates && (options.max_distance < 0 || options.max_distance > 63)) {
+		throw std::invalid_argument("Near duplicate distance must be in [0, 63]"s);
+	}
+	const std::vector<int> document_ids(search_server.begin(), search_server.end());
+	std::vector<Fingerprint> fingerprints(document_ids.size());
+	std::transform(std::execution::par, document_ids.begin(), document_ids.end(), fingerprints.begin(),
+		[&search_server](int document_id) {
+		return VisitWordFrequencies(search_server, document_id,
+			[](const std::pmr::map<std::string_view, double>& word_freqs) {
+			return ComputeFingerprint(word_freqs);
+		});
+	});
+
+	// documents are in ascending order of ids, so the first one of the
+	// equal ones is the original
+	std::vector<bool> is_duplicate(document_ids.size(), false);
+	std::vector<size_t> order(document_ids.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::sort(std::execution::par, order.begin(), order.end(), [&fingerprints](size_t lhs, size_t rhs) {
+		return std::pair(fingerprints[lhs].words_hash, lhs) < std::pair(fingerprints[rhs].words_hash, rhs);
+	});
+	// a hash match is confirmed by comparing the word sets, so a collision
+	// never removes a unique document; a run of equal hashes normally holds
+	// a single set
+	for (size_t run_begin = 0; run_begin < order.size();) {
+		size_t run_end = run_begin + 1;
+		while (run_end < order.size()
+			&& fingerprints[order[run_end]].words_hash == fingerprints[order[run_begin]].words_hash) {
+			++run_end;
+		}
+		if (run_end - run_begin > 1) {
+			std::vector<std::vector<std::string_view>> original_word_sets;
+			for (size_t i = run_begin; i < run_end; ++i) {
+				auto words = GetDocumentWords(search_server, document_ids[order[i]]);
+				if (std::find(original_word_sets.begin(), original_word_sets.end(), words) != original_word_sets.end()) {
+					is_duplicate[order[i]] = true;
+				}
+				else {
+					original_word_sets.push_back(std::move(words));
+				}
+			}
+		}
+		run_begin = run_end;
+	}
+	if (options.find_near_duplicates) {
+		for (const size_t index : FindNearDuplicates(fingerprints, options.max_distance)) {
+			is_duplicate[index] = true;
+		}
+	}
+
+	std::vector<int> duplicates;
+	for (size_t index = 0; index < document_ids.size(); ++index) {
+		if (is_duplicate[index]) {
+			duplicates.push_back(document_ids[index]);
+		}
+	}
+	return duplicates;
+}
+
+std::vector<int> RemoveDuplicates(SearchServer& search_server,
+	const DuplicateSearchOptions& options)
+{
+	return RemoveDuplicates(std::execution::seq, search_server, options);
+}
@@ -1,3 +1,36 @@
-#pragma once
-
-void RemoveDuplicates(SearchServer& search_server);
\ No newline at end of file
+#pragma once
+#include "search_server.h"
+
+#include <vector>
+
+struct DuplicateSearchOptions {
+	// Besides documents with equal sets of words, report near duplicates:
+	// documents whose 64-bit SimHash fingerprints differ in at most
+	// max_distance bits. Must be in [0, 63]
+	bool find_near_duplicates = false;
+	int max_distance = 3;
+};
+
+// Returns the ids of documents which duplicate a document with a smaller id,
+// in ascending order. Documents are compared by fingerprints of their word
+// sets computed in parallel; equal word sets are found by a 128-bit hash and
+// confirmed by comparing the words
+std::vector<int> FindDuplicates(const SearchServer& search_server,
+	const DuplicateSearchOptions& options = {});
+
+// Removes the documents found by FindDuplicates and returns their ids.
+// The removal is sequential, so the server may use any memory resource
+std::vector<int> RemoveDuplicates(SearchServer& search_server,
+	const DuplicateSearchOptions& options = {});
+
+// The same with the removal run under the policy. A parallel removal frees
+// and allocates postings on several threads, so the memory resource of the
+// server must be thread safe, e.g. a synchronized_pool_resource
+template <typename ExecutionPolicy>
+std::vector<int> RemoveDuplicates(const ExecutionPolicy& policy, SearchServer& search_server,
+	const DuplicateSearchOptions& options = {})
+{
+	auto duplicates = FindDuplicates(search_server, options);
+	search_server.RemoveDocuments(policy, duplicates);
+	return duplicates;
+}
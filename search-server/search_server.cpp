@@ -1,284 +1,794 @@
-#include "search_server.h"
-
-#include <numeric>
-#include <algorithm>
-#include <execution>
-
-void SearchServer::AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings) {
-	if ((document_id < 0) || (documents_.count(document_id) > 0)) {
-		throw std::invalid_argument("Invalid document_id"s);
-	}
-
-	const auto [it, inserted] = documents_.emplace(document_id,
-		DocumentData{ ComputeAverageRating(ratings), status, std::string(document) });
-	
-	const auto words = SplitIntoWordsNoStop(it->second.data);
-
-	const double inv_word_count = 1.0 / words.size();
-	for (std::string_view word : words) {
-		word_to_document_freqs_[word][document_id] += inv_word_count;
-		document_to_word_freqs_[document_id][word] += inv_word_count;
-	}
-	document_ids_.insert(document_id);
-}
-
-std::vector<Document> SearchServer::FindTopDocuments(
-	std::string_view raw_query, DocumentStatus status) const 
-{
-	return FindTopDocuments(raw_query,
-		[status](int document_id, DocumentStatus document_status, int rating) {
-		return document_status == status;
-	});
-}
-
-std::vector<Document> SearchServer::FindTopDocuments(
-	const std::execution::parallel_policy& policy,
-	std::string_view raw_query, DocumentStatus status) const
-{
-	return FindTopDocuments(policy, raw_query,
-		[status](int document_id, DocumentStatus document_status, int rating) 
-	{
-		return document_status == status;
-	});
-}
-
-std::vector<Document> SearchServer::FindTopDocuments(
-	const std::execution::sequenced_policy& policy,
-	std::string_view raw_query, DocumentStatus status) const
-{
-	return FindTopDocuments(raw_query,[status]
-	(int document_id, DocumentStatus document_status, int rating) 
-	{
-		return document_status == status;
-	});
-}
-
-std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query) const
-{
-	return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
-}
-
-std::vector<Document> SearchServer::FindTopDocuments(
-	const std::execution::parallel_policy& policy,
-	std::string_view raw_query) const
-{
-	return FindTopDocuments(policy, raw_query, DocumentStatus::ACTUAL);
-}
-
-std::vector<Document> SearchServer::FindTopDocuments(
-	const std::execution::sequenced_policy& policy,
-	std::string_view raw_query) const
-{
-	return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
-}
-
-int SearchServer::GetDocumentCount() const {
-	return documents_.size();
-}
-
-const std::map<std::string_view, double>& SearchServer::GetWordFrequencies(int document_id) const
-{
-	static std::map<std::string_view, double> emptyRes;
-	if (document_to_word_freqs_.count(document_id)) {
-		return document_to_word_freqs_.at(document_id);
-	}
-	else {
-		return emptyRes;
-	}
-}
-
-void SearchServer::RemoveDocument(int document_id) {
-	RemoveDocument(std::execution::seq, document_id);
-}
-
-const std::set<int>::const_iterator SearchServer::begin() const
-{
-	return document_ids_.cbegin();
-}
-
-const std::set<int>::const_iterator SearchServer::end() const
-{
-	return document_ids_.cend();
-}
-
-std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(
-	 const std::string_view raw_query, int document_id) const
-{
-	return MatchDocument(std::execution::seq, raw_query, document_id);
-}
-
-std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(
-	const std::execution::parallel_policy & policy, std::string_view raw_query,
-	int document_id) const
-{
-	const auto query = ParseQueryNoUniq(raw_query);
-	std::vector<std::string_view> zero{};
-	std::vector<std::string_view> matched_words(query.plus_words.size());
-	// verifying that there are no minus word
-	if (std::any_of(query.minus_words.begin(), query.minus_words.end(),
-		[this, &document_id](std::string_view word) {
-		return word_to_document_freqs_.at(word).count(document_id);
-	})) 
-	{
-		return { zero , documents_.at(document_id).status };
-	}
-
-	// copy matching words plus if there are no word minus
-	auto end_vector = std::copy_if(policy,
-		query.plus_words.begin(),
-		query.plus_words.end(),
-		matched_words.begin(),
-		[this, &document_id](std::string_view word) {
-		return 	word_to_document_freqs_.at(word).count(document_id);
-	});
-	
-	// make sort
-	std::sort(matched_words.begin(), end_vector);
-
-	// apply std::unique which remove consequitive equal elements
-	auto last = std::unique(matched_words.begin(), end_vector);
-
-	// resize vectors by new size
-	size_t newSize = last - matched_words.begin();
-	matched_words.resize(newSize);
-
-	return { matched_words, documents_.at(document_id).status };
-}
-
-std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(
-	const std::execution::sequenced_policy & policy, std::string_view raw_query,
-	int document_id) const
-{
-	const auto query = ParseQuery(raw_query);
-
-	std::vector<std::string_view> matched_words;
-	std::vector<std::string_view> zero;
-	for (std::string_view word : query.minus_words) {
-		if (word_to_document_freqs_.count(word) == 0) {
-			continue;
-		}
-		if (word_to_document_freqs_.at(word).count(document_id)) {
-			return { zero, documents_.at(document_id).status };
-		}
-	}
-
-	for (std::string_view word : query.plus_words) {
-		if (word_to_document_freqs_.count(word) == 0) {
-			continue;
-		}
-		if (word_to_document_freqs_.at(word).count(document_id)) {
-			matched_words.push_back(word);
-		}
-	}
-	return { matched_words, documents_.at(document_id).status };
-}
-
-bool SearchServer::IsStopWord(std::string_view word) const
-{
-	return stop_words_.count(word) > 0;
-}
-
-bool SearchServer::IsValidWord(std::string_view word)
-{
-	// A valid word must not contain special characters
-	return std::none_of(word.begin(), word.end(), [](char c) {
-		return c >= '\0' && c < ' ';
-	});
-}
-
-std::vector<std::string_view> SearchServer::SplitIntoWordsNoStop(
-	std::string_view text) const
-{
-	std::vector<std::string_view> words;
-	for (auto word : SplitIntoWords(text)) {
-		if (!IsValidWord(word)) {
-			throw std::invalid_argument("Word "s + word.data() + " is invalid"s);
-		}
-		if (!IsStopWord(word)) {
-			words.push_back(word);
-		}
-	}
-	return words;
-}
-
-int SearchServer::ComputeAverageRating(const std::vector<int>& ratings)
-{
-	if (ratings.empty()) {
-		return 0;
-	}
-	int rating_sum = std::accumulate(ratings.begin(), ratings.end(), 0);
-	return rating_sum / static_cast<int>(ratings.size());
-}
-
-SearchServer::QueryWord SearchServer::ParseQueryWord(std::string_view text) const
-{
-	if (text.empty()) {
-		throw std::invalid_argument("Query word is empty"s);
-	}
-	std::string_view word = text;
-	bool is_minus = false;
-	if (word[0] == '-') {
-		is_minus = true;
-		word = word.substr(1);
-	}
-	if (word.empty() || word[0] == '-' || !IsValidWord(word)) {
-		throw std::invalid_argument("Query word "s + word.data() + " is invalid"s);
-	}
-
-	return { word, is_minus, IsStopWord(word) };
-}
-
-SearchServer::Query SearchServer::ParseQuery(std::string_view text) const
-{
-	Query result;
-	for (std::string_view word : SplitIntoWords(text)) {
-		const auto query_word = ParseQueryWord(word);
-		if (!query_word.is_stop) {
-			if (query_word.is_minus) {
-				result.minus_words.push_back(query_word.data);
-			}
-			else {
-				result.plus_words.push_back(query_word.data);
-			}
-		}
-	}
-	// make sort for minus and plus words
-	std::sort(result.minus_words.begin(), result.minus_words.end());
-	std::sort(result.plus_words.begin(), result.plus_words.end());
-
-	// apply std::unique which remove consequitive equal elements
-	auto last_minus = std::unique(result.minus_words.begin(), result.minus_words.end());
-	auto last_plus = std::unique(result.plus_words.begin(), result.plus_words.end());
-	
-	// resize vectors by new size
-	size_t newSize = last_minus - result.minus_words.begin();
-	result.minus_words.resize(newSize);
-
-	newSize = last_plus - result.plus_words.begin();
-	result.plus_words.resize(newSize);
-
-	return result;
-}
-
-SearchServer::Query SearchServer::ParseQueryNoUniq(std::string_view text) const
-{
-	Query result;
-
-	for (std::string_view word : SplitIntoWords(text)) {
-		const auto query_word = ParseQueryWord(word);
-		if (!query_word.is_stop) {
-			if (query_word.is_minus) {
-				result.minus_words.push_back(query_word.data);
-			}
-			else {
-				result.plus_words.push_back(query_word.data);
-			}
-		}
-	}
-	return result;
-}
-
-double SearchServer::ComputeWordInverseDocumentFreq(std::string_view word) const
-{
-	return log(GetDocumentCount() * 1.0 / word_to_document_freqs_.at(word).size());
-}
+#include "search_server.h"
+
+#include <numeric>
+#include <algorithm>
+#include <execution>
+#include <cstdint>
+#include <chrono>
+
+SearchServer::SearchServer(SearchServer&& other)
+	: SearchServer(std::move(other), FinishCompactionOf(other))
+{
+}
+
+SearchServer::SearchServer(SearchServer&& other, CompactionFinished)
+	: stop_words_(other.stop_words_)
+	, stop_word_filter_(stop_words_)
+	, forward_index_mode_(other.forward_index_mode_)
+	, word_to_document_freqs_(std::move(other.word_to_document_freqs_))
+	, document_texts_(std::move(other.document_texts_))
+	, document_to_word_freqs_(std::move(other.document_to_word_freqs_))
+	, document_words_(std::move(other.document_words_))
+	, document_word_offsets_(std::move(other.document_word_offsets_))
+	, documents_(std::move(other.documents_))
+	, document_ordinals_(std::move(other.document_ordinals_))
+	, document_ids_(std::move(other.document_ids_))
+	, log_document_count_(other.log_document_count_)
+	, generation_(other.generation_)
+	, query_cache_(std::move(other.query_cache_))
+	, word_freqs_cache_(std::move(other.word_freqs_cache_))
+	, removal_mode_(other.removal_mode_)
+	, tombstones_(std::move(other.tombstones_))
+	, pending_tombstones_(std::move(other.pending_tombstones_))
+	, compacting_ordinals_(std::move(other.compacting_ordinals_))
+{
+}
+
+SearchServer::CompactionFinished SearchServer::FinishCompactionOf(SearchServer& search_server)
+{
+	search_server.FinishCompaction();
+	return {};
+}
+
+void SearchServer::AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings) {
+	if ((document_id < 0) || (document_ordinals_.count(document_id) > 0)) {
+		throw std::invalid_argument("Invalid document_id"s);
+	}
+
+	const auto words = SplitIntoWordsNoStop(document);
+	FinishCompaction();
+
+	const int ordinal = static_cast<int>(documents_.size());
+	documents_.push_back({ document_id, ComputeAverageRating(ratings), status, document_texts_.Append(document) });
+	tombstones_.push_back(false);
+	document_ordinals_.emplace(document_id, ordinal);
+
+	const double inv_word_count = 1.0 / words.size();
+	auto* word_freqs = forward_index_mode_ == ForwardIndexMode::FULL
+		? &document_to_word_freqs_.emplace_back() : nullptr;
+	for (std::string_view word : words) {
+		auto [term, postings] = word_to_document_freqs_.Insert(word);
+		postings.AddTermFreq(ordinal, inv_word_count);
+		if (word_freqs != nullptr) {
+			(*word_freqs)[term] += inv_word_count;
+		}
+	}
+	if (forward_index_mode_ == ForwardIndexMode::COMPACT) {
+		AppendDocumentWords(ComputeWordFrequencies(words));
+	}
+	document_ids_.insert(document_id);
+	OnDocumentsChanged();
+}
+
+void SearchServer::AddDocuments(const std::vector<RawDocument>& documents)
+{
+	AddDocumentsImpl(std::execution::seq, documents);
+}
+
+void SearchServer::AddDocuments(const std::execution::sequenced_policy& policy,
+	const std::vector<RawDocument>& documents)
+{
+	AddDocumentsImpl(policy, documents);
+}
+
+void SearchServer::AddDocuments(const std::execution::parallel_policy& policy,
+	const std::vector<RawDocument>& documents)
+{
+	AddDocumentsImpl(policy, documents);
+}
+
+template <typename ExecutionPolicy>
+void SearchServer::AddDocumentsImpl(ExecutionPolicy&& policy, const std::vector<RawDocument>& documents)
+{
+	std::vector<int> new_ids(documents.size());
+	std::transform(documents.begin(), documents.end(), new_ids.begin(),
+		[](const RawDocument& document) { return document.id; });
+	std::sort(new_ids.begin(), new_ids.end());
+	if (std::adjacent_find(new_ids.begin(), new_ids.end()) != new_ids.end()
+		|| std::any_of(new_ids.begin(), new_ids.end(), [this](int document_id) {
+		return document_id < 0 || document_ordinals_.count(document_id) > 0;
+	})) {
+		throw std::invalid_argument("Invalid document_id"s);
+	}
+
+	// words of every document with their term frequencies, sorted by word;
+	// exceptions must not leave a parallel algorithm, so errors are collected
+	struct TokenizedDocument {
+		std::vector<std::pair<std::string_view, double>> word_freqs;
+		std::vector<PostingList*> postings;
+		std::string error;
+	};
+	std::vector<TokenizedDocument> tokenized(documents.size());
+	std::transform(policy, documents.begin(), documents.end(), tokenized.begin(),
+		[this](const RawDocument& document) {
+		TokenizedDocument result;
+		try {
+			result.word_freqs = ComputeWordFrequencies(SplitIntoWordsNoStop(document.text));
+		}
+		catch (const std::invalid_argument& e) {
+			result.error = e.what();
+		}
+		return result;
+	});
+	for (const auto& document : tokenized) {
+		if (!document.error.empty()) {
+			throw std::invalid_argument(document.error);
+		}
+	}
+
+	std::vector<size_t> indexes(documents.size());
+	std::iota(indexes.begin(), indexes.end(), 0);
+
+	// terms already in the dictionary are resolved concurrently,
+	// only new ones are inserted sequentially afterwards
+	std::for_each(policy, indexes.begin(), indexes.end(),
+		[this, &tokenized](size_t index) {
+		auto& document = tokenized[index];
+		document.postings.resize(document.word_freqs.size());
+		for (size_t i = 0; i < document.word_freqs.size(); ++i) {
+			auto [term, postings] = word_to_document_freqs_.FindTerm(document.word_freqs[i].first);
+			if (postings != nullptr) {
+				document.word_freqs[i].first = term;
+				document.postings[i] = postings;
+			}
+		}
+	});
+
+	FinishCompaction();
+	const int first_ordinal = static_cast<int>(documents_.size());
+	documents_.reserve(documents_.size() + documents.size());
+	if (forward_index_mode_ == ForwardIndexMode::FULL) {
+		document_to_word_freqs_.resize(documents_.size() + documents.size());
+	}
+	tombstones_.resize(documents_.size() + documents.size(), false);
+	for (size_t index = 0; index < documents.size(); ++index) {
+		const RawDocument& document = documents[index];
+		documents_.push_back({ document.id, ComputeAverageRating(document.ratings),
+			document.status, document_texts_.Append(document.text) });
+		document_ordinals_.emplace(document.id, first_ordinal + static_cast<int>(index));
+		document_ids_.insert(document.id);
+		auto& tokenized_document = tokenized[index];
+		for (size_t i = 0; i < tokenized_document.word_freqs.size(); ++i) {
+			if (tokenized_document.postings[i] == nullptr) {
+				auto [term, postings] = word_to_document_freqs_.Insert(tokenized_document.word_freqs[i].first);
+				tokenized_document.word_freqs[i].first = term;
+				tokenized_document.postings[i] = &postings;
+			}
+		}
+	}
+
+	if (forward_index_mode_ == ForwardIndexMode::FULL) {
+		std::for_each(policy, indexes.begin(), indexes.end(),
+			[this, &tokenized, first_ordinal](size_t index) {
+			auto& word_freqs = document_to_word_freqs_[first_ordinal + index];
+			for (const auto& [term, term_freq] : tokenized[index].word_freqs) {
+				word_freqs.emplace_hint(word_freqs.end(), term, term_freq);
+			}
+		});
+	}
+	else if (forward_index_mode_ == ForwardIndexMode::COMPACT) {
+		for (const auto& document : tokenized) {
+			AppendDocumentWords(document.word_freqs);
+		}
+	}
+
+	// posting lists are split between shards by a hash of the list address.
+	// Every task first buckets the postings of a contiguous range of documents
+	// by shard, then every task appends the buckets of its own shard range by
+	// range; new ordinals exceed all existing ones, so appending in document
+	// order keeps lists sorted
+	const size_t shard_count = std::is_same_v<std::decay_t<ExecutionPolicy>, std::execution::parallel_policy>
+		? std::max(1u, std::thread::hardware_concurrency()) : 1;
+	if (shard_count == 1) {
+		for (size_t index = 0; index < tokenized.size(); ++index) {
+			const auto& document = tokenized[index];
+			for (size_t i = 0; i < document.postings.size(); ++i) {
+				document.postings[i]->AddTermFreq(first_ordinal + static_cast<int>(index),
+					document.word_freqs[i].second);
+			}
+		}
+		OnDocumentsChanged();
+		return;
+	}
+
+	struct PendingPosting {
+		PostingList* postings = nullptr;
+		int ordinal = 0;
+		double term_freq = 0.0;
+	};
+	std::vector<size_t> shards(shard_count);
+	std::iota(shards.begin(), shards.end(), 0);
+	const size_t range_size = (tokenized.size() + shard_count - 1) / shard_count;
+	// indexed by document range, then by shard
+	std::vector<std::vector<std::vector<PendingPosting>>> buckets(shard_count,
+		std::vector<std::vector<PendingPosting>>(shard_count));
+	std::for_each(policy, shards.begin(), shards.end(),
+		[&tokenized, &buckets, first_ordinal, shard_count, range_size](size_t range) {
+		const size_t last_index = std::min(tokenized.size(), (range + 1) * range_size);
+		for (size_t index = range * range_size; index < last_index; ++index) {
+			const auto& document = tokenized[index];
+			for (size_t i = 0; i < document.postings.size(); ++i) {
+				const uint64_t address = reinterpret_cast<uintptr_t>(document.postings[i]);
+				const size_t shard = (address * 0x9E3779B97F4A7C15ULL >> 32) % shard_count;
+				buckets[range][shard].push_back({ document.postings[i],
+					first_ordinal + static_cast<int>(index), document.word_freqs[i].second });
+			}
+		}
+	});
+	std::for_each(policy, shards.begin(), shards.end(), [&buckets](size_t shard) {
+		for (const auto& range_buckets : buckets) {
+			for (const PendingPosting& posting : range_buckets[shard]) {
+				posting.postings->AddTermFreq(posting.ordinal, posting.term_freq);
+			}
+		}
+	});
+	OnDocumentsChanged();
+}
+
+std::vector<Document> SearchServer::FindTopDocuments(
+	std::string_view raw_query, DocumentStatus status,
+	size_t max_result_count) const 
+{
+	return FindTopDocumentsImpl(std::execution::seq, raw_query,
+		[status](int document_id, DocumentStatus document_status, int rating) {
+		return document_status == status;
+	}, GetPredicateKey(status), max_result_count);
+}
+
+std::vector<Document> SearchServer::FindTopDocuments(
+	const std::execution::parallel_policy& policy,
+	std::string_view raw_query, DocumentStatus status,
+	size_t max_result_count) const
+{
+	return FindTopDocumentsImpl(policy, raw_query,
+		[status](int document_id, DocumentStatus document_status, int rating) 
+	{
+		return document_status == status;
+	}, GetPredicateKey(status), max_result_count);
+}
+
+std::vector<Document> SearchServer::FindTopDocuments(
+	const std::execution::sequenced_policy& policy,
+	std::string_view raw_query, DocumentStatus status,
+	size_t max_result_count) const
+{
+	return FindTopDocumentsImpl(policy, raw_query,[status]
+	(int document_id, DocumentStatus document_status, int rating) 
+	{
+		return document_status == status;
+	}, GetPredicateKey(status), max_result_count);
+}
+
+std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query) const
+{
+	return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
+}
+
+std::vector<Document> SearchServer::FindTopDocuments(
+	const std::execution::parallel_policy& policy,
+	std::string_view raw_query) const
+{
+	return FindTopDocuments(policy, raw_query, DocumentStatus::ACTUAL);
+}
+
+std::vector<Document> SearchServer::FindTopDocuments(
+	const std::execution::sequenced_policy& policy,
+	std::string_view raw_query) const
+{
+	return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
+}
+
+void SearchServer::SetQueryCacheCapacity(size_t capacity)
+{
+	if (capacity == 0) {
+		query_cache_.reset();
+	}
+	else {
+		query_cache_ = std::make_unique<QueryCache>(capacity);
+	}
+}
+
+int SearchServer::GetDocumentCount() const {
+	return document_ordinals_.size();
+}
+
+const std::pmr::map<std::string_view, double>& SearchServer::GetWordFrequencies(int document_id) const
+{
+	static const std::pmr::map<std::string_view, double> emptyRes;
+	const auto it = document_ordinals_.find(document_id);
+	if (it == document_ordinals_.end()) {
+		return emptyRes;
+	}
+	const int ordinal = it->second;
+	if (forward_index_mode_ == ForwardIndexMode::FULL) {
+		return document_to_word_freqs_[ordinal];
+	}
+	{
+		std::lock_guard lock(word_freqs_cache_->mutex);
+		const auto cached = word_freqs_cache_->word_freqs.find(ordinal);
+		if (cached != word_freqs_cache_->word_freqs.end()) {
+			return cached->second;
+		}
+	}
+	// built outside the lock; if another thread cached the map meanwhile,
+	// its map is kept and returned
+	auto word_freqs = GetWordFrequenciesCopy(document_id);
+	std::lock_guard lock(word_freqs_cache_->mutex);
+	return word_freqs_cache_->word_freqs.try_emplace(ordinal, std::move(word_freqs)).first->second;
+}
+
+std::pmr::map<std::string_view, double> SearchServer::GetWordFrequenciesCopy(int document_id) const
+{
+	std::pmr::map<std::string_view, double> word_freqs;
+	const auto it = document_ordinals_.find(document_id);
+	if (it == document_ordinals_.end()) {
+		return word_freqs;
+	}
+	ForEachDocumentWord(it->second, [&word_freqs](std::string_view word, double term_freq) {
+		word_freqs.emplace(word, term_freq);
+	});
+	return word_freqs;
+}
+
+ForwardIndexMode SearchServer::GetForwardIndexMode() const
+{
+	return forward_index_mode_;
+}
+
+SearchServerMemoryStats SearchServer::GetMemoryStats() const
+{
+	SearchServerMemoryStats stats;
+	stats.term_dictionary = word_to_document_freqs_.GetDictionaryMemoryUsage();
+	stats.postings = word_to_document_freqs_.GetPostingsMemoryUsage();
+
+	stats.forward_index.bytes = document_to_word_freqs_.capacity() * sizeof(document_to_word_freqs_[0]);
+	for (const auto& word_freqs : document_to_word_freqs_) {
+		stats.forward_index.bytes += EstimateTreeBytes(word_freqs);
+		stats.forward_index.count += word_freqs.size();
+	}
+	stats.forward_index.bytes += document_words_.capacity() * sizeof(DocumentWord)
+		+ document_word_offsets_.capacity() * sizeof(size_t);
+	stats.forward_index.count += document_words_.size();
+	{
+		std::lock_guard lock(word_freqs_cache_->mutex);
+		stats.forward_index.bytes += EstimateHashBytes(word_freqs_cache_->word_freqs);
+		for (const auto& [ordinal, word_freqs] : word_freqs_cache_->word_freqs) {
+			stats.forward_index.bytes += EstimateTreeBytes(word_freqs);
+		}
+	}
+
+	stats.documents.bytes = documents_.capacity() * sizeof(DocumentData)
+		+ EstimateHashBytes(document_ordinals_) + EstimateTreeBytes(document_ids_)
+		+ tombstones_.capacity() / 8
+		+ (pending_tombstones_.capacity() + compacting_ordinals_.capacity()) * sizeof(int);
+	stats.documents.count = document_ordinals_.size();
+
+	stats.document_texts = { document_texts_.GetByteSize(), documents_.size() };
+
+	stats.stop_words = { EstimateTreeBytes(stop_words_), stop_words_.size() };
+	for (const std::string& stop_word : stop_words_) {
+		stats.stop_words.bytes += GetStringHeapBytes(stop_word);
+	}
+	stats.stop_words.bytes += stop_word_filter_.GetByteSize();
+
+	if (query_cache_) {
+		stats.query_cache = query_cache_->GetMemoryUsage();
+	}
+	return stats;
+}
+
+void SearchServer::RemoveDocument(int document_id) {
+	RemoveDocument(std::execution::seq, document_id);
+}
+
+void SearchServer::RemoveOrdinals(const std::execution::sequenced_policy& policy, std::vector<int> ordinals)
+{
+	RemoveOrdinalsImpl(policy, std::move(ordinals));
+}
+
+void SearchServer::RemoveOrdinals(const std::execution::parallel_policy& policy, std::vector<int> ordinals)
+{
+	RemoveOrdinalsImpl(policy, std::move(ordinals));
+}
+
+template <typename ExecutionPolicy>
+void SearchServer::RemoveOrdinalsImpl(ExecutionPolicy&& policy, std::vector<int> ordinals)
+{
+	std::sort(ordinals.begin(), ordinals.end());
+	ordinals.erase(std::unique(ordinals.begin(), ordinals.end()), ordinals.end());
+	if (ordinals.empty()) {
+		return;
+	}
+	const bool is_deferred = removal_mode_ == RemovalMode::DEFERRED;
+	if (!is_deferred) {
+		FinishCompaction();
+	}
+
+	// posting lists of the removed documents, a list appears once per
+	// removed document which mentions it
+	std::vector<std::vector<PostingList*>> document_postings(ordinals.size());
+	std::transform(policy, ordinals.begin(), ordinals.end(), document_postings.begin(),
+		[this](int ordinal) {
+		std::vector<PostingList*> result;
+		ForEachDocumentWord(ordinal, [this, &result](std::string_view word, double) {
+			result.push_back(word_to_document_freqs_.Find(word));
+		});
+		return result;
+	});
+	std::vector<PostingList*> postings;
+	for (const auto& document : document_postings) {
+		postings.insert(postings.end(), document.begin(), document.end());
+	}
+	std::sort(policy, postings.begin(), postings.end());
+
+	if (is_deferred) {
+		// a run of equal pointers is one list and the number of its documents removed
+		std::vector<std::pair<PostingList*, size_t>> deleted_counts;
+		for (PostingList* posting_list : postings) {
+			if (deleted_counts.empty() || deleted_counts.back().first != posting_list) {
+				deleted_counts.emplace_back(posting_list, 0);
+			}
+			++deleted_counts.back().second;
+		}
+		std::for_each(policy, deleted_counts.begin(), deleted_counts.end(), [](const auto& deleted_count) {
+			deleted_count.first->MarkDeleted(deleted_count.second);
+		});
+		for (const int ordinal : ordinals) {
+			tombstones_[ordinal] = true;
+			pending_tombstones_.push_back(ordinal);
+		}
+	}
+	else {
+		postings.erase(std::unique(postings.begin(), postings.end()), postings.end());
+		std::vector<bool> is_removed(documents_.size(), false);
+		for (const int ordinal : ordinals) {
+			is_removed[ordinal] = true;
+		}
+		std::for_each(policy, postings.begin(), postings.end(), [&is_removed](PostingList* posting_list) {
+			posting_list->EraseDocuments(is_removed);
+		});
+	}
+
+	for (const int ordinal : ordinals) {
+		document_ordinals_.erase(documents_[ordinal].id);
+		document_ids_.erase(documents_[ordinal].id);
+		word_freqs_cache_->word_freqs.erase(ordinal);
+	}
+	// words of a deferred removed document are kept until compaction,
+	// and so is its text, the only source of the words in the NONE mode
+	std::for_each(policy, ordinals.begin(), ordinals.end(), [this, is_deferred](int ordinal) {
+		std::string_view data;
+		if (is_deferred) {
+			data = documents_[ordinal].data;
+		}
+		else if (forward_index_mode_ == ForwardIndexMode::FULL) {
+			document_to_word_freqs_[ordinal].clear();
+		}
+		documents_[ordinal] = DocumentData{};
+		documents_[ordinal].data = data;
+	});
+	OnDocumentsChanged();
+}
+
+void SearchServer::SetRemovalMode(RemovalMode mode)
+{
+	removal_mode_ = mode;
+}
+
+void SearchServer::StartCompaction()
+{
+	if (compaction_.valid() || pending_tombstones_.empty()) {
+		return;
+	}
+	compacting_ordinals_ = std::move(pending_tombstones_);
+	pending_tombstones_.clear();
+	compaction_ = std::async(std::launch::async, [this]() {
+		return CompactPostings(compacting_ordinals_);
+	});
+}
+
+bool SearchServer::TryFinishCompaction()
+{
+	if (compaction_.valid()
+		&& compaction_.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+		FinishCompaction();
+	}
+	return !compaction_.valid();
+}
+
+void SearchServer::FinishCompaction()
+{
+	if (!compaction_.valid()) {
+		return;
+	}
+	auto compacted_postings = compaction_.get();
+	for (auto& [posting_list, compacted] : compacted_postings) {
+		posting_list->ApplyCompaction(std::move(compacted));
+	}
+	// the words are released here rather than in the background task, so the
+	// task only reads the forward index and never frees from the resource
+	for (const int ordinal : compacting_ordinals_) {
+		if (forward_index_mode_ == ForwardIndexMode::FULL) {
+			document_to_word_freqs_[ordinal].clear();
+		}
+		documents_[ordinal].data = {};
+	}
+	compacting_ordinals_.clear();
+}
+
+bool SearchServer::IsCompactionRunning() const
+{
+	return compaction_.valid();
+}
+
+void SearchServer::CompressPostings()
+{
+	CompressPostingsImpl(std::execution::seq);
+}
+
+void SearchServer::CompressPostings(const std::execution::sequenced_policy& policy)
+{
+	CompressPostingsImpl(policy);
+}
+
+void SearchServer::CompressPostings(const std::execution::parallel_policy& policy)
+{
+	CompressPostingsImpl(policy);
+}
+
+template <typename ExecutionPolicy>
+void SearchServer::CompressPostingsImpl(ExecutionPolicy&& policy)
+{
+	// the background compaction reads the plain arrays
+	FinishCompaction();
+	std::vector<uint32_t> term_ids(word_to_document_freqs_.GetTermCount());
+	std::iota(term_ids.begin(), term_ids.end(), 0);
+	std::for_each(policy, term_ids.begin(), term_ids.end(), [this](uint32_t term_id) {
+		word_to_document_freqs_.GetPostings(term_id).Compress();
+	});
+}
+
+size_t SearchServer::GetDeletedDocumentCount() const
+{
+	return pending_tombstones_.size() + compacting_ordinals_.size();
+}
+
+std::vector<std::pair<PostingList*, PostingList>> SearchServer::CompactPostings(
+	const std::vector<int>& ordinals)
+{
+	// runs in the background: reads only the posting list arrays and the words
+	// of the given documents, which no concurrent operation changes, and
+	// allocates the copies from the default resource
+	std::vector<bool> is_compacted(documents_.size(), false);
+	std::vector<PostingList*> postings;
+	for (const int ordinal : ordinals) {
+		is_compacted[ordinal] = true;
+		ForEachDocumentWord(ordinal, [this, &postings](std::string_view word, double) {
+			postings.push_back(word_to_document_freqs_.Find(word));
+		});
+	}
+	std::sort(postings.begin(), postings.end());
+	postings.erase(std::unique(postings.begin(), postings.end()), postings.end());
+
+	std::vector<std::pair<PostingList*, PostingList>> result;
+	result.reserve(postings.size());
+	for (PostingList* posting_list : postings) {
+		result.emplace_back(posting_list, posting_list->WithoutDocuments(is_compacted));
+	}
+	return result;
+}
+
+const std::pmr::set<int>::const_iterator SearchServer::begin() const
+{
+	return document_ids_.cbegin();
+}
+
+const std::pmr::set<int>::const_iterator SearchServer::end() const
+{
+	return document_ids_.cend();
+}
+
+std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(
+	 const std::string_view raw_query, int document_id) const
+{
+	return MatchDocument(std::execution::seq, raw_query, document_id);
+}
+
+std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(
+	const std::execution::parallel_policy & policy, std::string_view raw_query,
+	int document_id) const
+{
+	const auto query = ParseQueryNoUniq(raw_query);
+	const int ordinal = document_ordinals_.at(document_id);
+	std::vector<std::string_view> zero{};
+	std::vector<std::string_view> matched_words(query.plus_words.size());
+	// verifying that there are no minus word
+	if (std::any_of(query.minus_words.begin(), query.minus_words.end(),
+		[this, ordinal](std::string_view word) {
+		const PostingList* postings = word_to_document_freqs_.Find(word);
+		return postings != nullptr && postings->Contains(ordinal);
+	})) 
+	{
+		return { zero , documents_[ordinal].status };
+	}
+
+	// copy matching words plus if there are no word minus
+	auto end_vector = std::copy_if(policy,
+		query.plus_words.begin(),
+		query.plus_words.end(),
+		matched_words.begin(),
+		[this, ordinal](std::string_view word) {
+		const PostingList* postings = word_to_document_freqs_.Find(word);
+		return postings != nullptr && postings->Contains(ordinal);
+	});
+	
+	// make sort
+	std::sort(matched_words.begin(), end_vector);
+
+	// apply std::unique which remove consequitive equal elements
+	auto last = std::unique(matched_words.begin(), end_vector);
+
+	// resize vectors by new size
+	size_t newSize = last - matched_words.begin();
+	matched_words.resize(newSize);
+
+	return { matched_words, documents_[ordinal].status };
+}
+
+std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(
+	const std::execution::sequenced_policy & policy, std::string_view raw_query,
+	int document_id) const
+{
+	const auto query = ParseQuery(raw_query);
+	const int ordinal = document_ordinals_.at(document_id);
+
+	std::vector<std::string_view> matched_words;
+	std::vector<std::string_view> zero;
+	for (std::string_view word : query.minus_words) {
+		const PostingList* postings = word_to_document_freqs_.Find(word);
+		if (postings != nullptr && postings->Contains(ordinal)) {
+			return { zero, documents_[ordinal].status };
+		}
+	}
+
+	for (std::string_view word : query.plus_words) {
+		const PostingList* postings = word_to_document_freqs_.Find(word);
+		if (postings != nullptr && postings->Contains(ordinal)) {
+			matched_words.push_back(word);
+		}
+	}
+	return { matched_words, documents_[ordinal].status };
+}
+
+bool SearchServer::IsStopWord(std::string_view word) const
+{
+	return stop_word_filter_.Contains(word);
+}
+
+bool SearchServer::IsValidWord(std::string_view word)
+{
+	// A valid word must not contain special characters
+	return !ContainsControlChars(word);
+}
+
+std::vector<std::string_view> SearchServer::SplitIntoWordsNoStop(
+	std::string_view text) const
+{
+	std::vector<std::string_view> words;
+	// validating the whole text at once is much cheaper than word by word,
+	// the words are checked one by one only to report the invalid one
+	const bool is_valid_text = !ContainsControlChars(text);
+	for (auto word : SplitIntoWords(text)) {
+		if (!is_valid_text && !IsValidWord(word)) {
+			throw std::invalid_argument("Word "s + std::string(word) + " is invalid"s);
+		}
+		if (!IsStopWord(word)) {
+			words.push_back(word);
+		}
+	}
+	return words;
+}
+
+std::vector<std::pair<std::string_view, double>> SearchServer::ComputeWordFrequencies(
+	std::vector<std::string_view> words)
+{
+	std::vector<std::pair<std::string_view, double>> word_freqs;
+	const double inv_word_count = 1.0 / words.size();
+	std::sort(words.begin(), words.end());
+	for (std::string_view word : words) {
+		if (word_freqs.empty() || word_freqs.back().first != word) {
+			word_freqs.emplace_back(word, 0.0);
+		}
+		// accumulated the same way AddDocument does to get equal values
+		word_freqs.back().second += inv_word_count;
+	}
+	return word_freqs;
+}
+
+void SearchServer::AppendDocumentWords(const std::vector<std::pair<std::string_view, double>>& word_freqs)
+{
+	const size_t first = document_words_.size();
+	for (const auto& [word, term_freq] : word_freqs) {
+		document_words_.push_back({ word_to_document_freqs_.FindTermId(word), term_freq });
+	}
+	std::sort(document_words_.begin() + first, document_words_.end(),
+		[](const DocumentWord& lhs, const DocumentWord& rhs) {
+		return lhs.term_id < rhs.term_id;
+	});
+	document_word_offsets_.push_back(document_words_.size());
+}
+
+int SearchServer::ComputeAverageRating(const std::vector<int>& ratings)
+{
+	if (ratings.empty()) {
+		return 0;
+	}
+	int rating_sum = std::accumulate(ratings.begin(), ratings.end(), 0);
+	return rating_sum / static_cast<int>(ratings.size());
+}
+
+Query SearchServer::ParseQuery(std::string_view text) const
+{
+	return ::ParseQuery(text, [this](std::string_view word) {
+		return IsStopWord(word);
+	});
+}
+
+Query SearchServer::ParseQueryNoUniq(std::string_view text) const
+{
+	return ::ParseQuery(text, [this](std::string_view word) {
+		return IsStopWord(word);
+	}, false);
+}
+
+SearchServer::ScoreScratch& SearchServer::GetThreadScoreScratch()
+{
+	thread_local ScoreScratch scratch;
+	return scratch;
+}
+
+void SearchServer::ScoreScratch::Reset()
+{
+	for (const int ordinal : touched) {
+		relevance[ordinal] = 0.0;
+		state[ordinal] = UNSEEN;
+	}
+	touched.clear();
+	is_used = false;
+}
+
+bool SearchServer::IsMoreRelevant(const Document& lhs, const Document& rhs)
+{
+	if (std::abs(lhs.relevance - rhs.relevance) < EPSILON) {
+		return lhs.rating > rhs.rating;
+	}
+	else {
+		return lhs.relevance > rhs.relevance;
+	}
+}
+
+double SearchServer::ComputeWordInverseDocumentFreq(const PostingList& postings) const
+{
+	return ComputeInverseDocumentFreq(log_document_count_, postings.GetLogDocumentFreq());
+}
+
+void SearchServer::OnDocumentsChanged()
+{
+	log_document_count_ = LogCount(GetDocumentCount());
+	++generation_;
+}
+
+QueryCache::PredicateKey SearchServer::GetPredicateKey(DocumentStatus status)
+{
+	return { typeid(DocumentStatus), static_cast<int>(status) };
+}
@@ -1,270 +1,852 @@
-#pragma once
-#include "document.h"
-#include "string_processing.h"
-#include "concurrent_map.h"
-
-#include <exception>
-#include <algorithm>
-#include <cmath>
-#include <tuple>
-#include <map>
-#include <execution>
-#include <string_view>
-
-using std::string_literals::operator""s;
-
-const int MAX_RESULT_DOCUMENT_COUNT = 5;
-const double EPSILON = 1e-6;
-
-class SearchServer
-{
-	
-public:
-	template <typename StringContainer>
-	explicit SearchServer(const StringContainer& stop_words)
-		: stop_words_(MakeUniqueNonEmptyStrings(stop_words))  // Extract non-empty stop words
-	{
-		if (!all_of(stop_words_.begin(), stop_words_.end(), IsValidWord)) {
-			throw std::invalid_argument("Some of stop words are invalid"s);
-		}
-	}
-
-	explicit SearchServer(const std::string& stop_words_text)
-		: SearchServer(SplitIntoWords(stop_words_text)) {}  // Invoke delegating constructor from string container
-	
-	void AddDocument(int document_id, std::string_view document,
-		DocumentStatus status, const std::vector<int>& ratings);
-	
-	template <typename DocumentPredicate>
-	std::vector<Document> FindTopDocuments(std::string_view raw_query,
-		DocumentPredicate document_predicate) const 
-	{
-		auto matched_documents = FindAllDocuments(raw_query, document_predicate);
-
-		std::sort(matched_documents.begin(), matched_documents.end(),
-			[](const Document& lhs, const Document& rhs) {
-			if (std::abs(lhs.relevance - rhs.relevance) < EPSILON) {
-				return lhs.rating > rhs.rating;
-			}
-			else {
-				return lhs.relevance > rhs.relevance;
-			}
-		});
-		
-		if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
-			matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
-		}
-		return matched_documents;
-	}
-
-	template <typename DocumentPredicate>
-	std::vector<Document> FindTopDocuments(
-		const std::execution::parallel_policy& policy, std::string_view raw_query,
-		DocumentPredicate document_predicate) const
-	{		
-		auto matched_documents = FindAllDocuments(policy, raw_query, document_predicate);
-
-		std::sort(matched_documents.begin(), matched_documents.end(),
-			[](const Document& lhs, const Document& rhs) {
-			if (std::abs(lhs.relevance - rhs.relevance) < EPSILON) {
-				return lhs.rating > rhs.rating;
-			}
-			else {
-				return lhs.relevance > rhs.relevance;
-			}
-		});
-		if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
-			matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
-		}
-		return matched_documents;
-
-	}
-
-	template <typename DocumentPredicate>
-	std::vector<Document> FindTopDocuments(
-		const std::execution::sequenced_policy& policy, std::string_view raw_query,
-		DocumentPredicate document_predicate) const
-	{
-		return FindTopDocuments(raw_query, document_predicate);
-
-	}
-
-	std::vector<Document> FindTopDocuments(std::string_view raw_query,
-		DocumentStatus status) const;
-
-	std::vector<Document> FindTopDocuments(
-		const std::execution::parallel_policy& policy, std::string_view raw_query,
-		DocumentStatus status) const;
-
-	std::vector<Document> FindTopDocuments(
-		const std::execution::sequenced_policy& policy,
-		std::string_view raw_query, DocumentStatus status) const;
-
-	std::vector<Document> FindTopDocuments(std::string_view raw_query) const;
-
-	std::vector<Document> FindTopDocuments(
-		const std::execution::parallel_policy& policy,
-		std::string_view raw_query) const;
-
-	std::vector<Document> FindTopDocuments(
-		const std::execution::sequenced_policy& policy,
-		std::string_view raw_query) const;
-	
-	int GetDocumentCount() const;
-
-	const std::map<std::string_view, double>& GetWordFrequencies(int document_id) const;
-
-	void RemoveDocument(int document_id);
-
-	template <typename Policy>
-	void RemoveDocument(Policy&& policy, int document_id)
-	{
-		if (documents_.count(document_id)) {
-			for (auto& word : document_to_word_freqs_[document_id]) {
-				word_to_document_freqs_[word.first].erase(document_id);
-			}
-			documents_.erase(document_id);
-			document_ids_.erase(document_id);
-			document_to_word_freqs_.erase(document_id);
-		}
-	}
-
-	const std::set<int>::const_iterator begin() const;
-
-	const std::set<int>::const_iterator end() const;
-
-	std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(
-		std::string_view raw_query, int document_id) const;
-
-	std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(
-		const std::execution::parallel_policy& policy, 
-		std::string_view raw_query, int document_id) const;
-
-	std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(
-		const std::execution::sequenced_policy& policy, 
-		std::string_view raw_query, int document_id) const;
-
-private:
-	struct DocumentData {
-		int rating;
-		DocumentStatus status;
-		std::string data;
-	};
-	const std::set<std::string, std::less<>> stop_words_;
-	std::map<std::string_view, std::map<int, double>> word_to_document_freqs_;
-	std::map<int, std::map<std::string_view, double>> document_to_word_freqs_;
-	std::map<int, DocumentData> documents_;
-	std::set<int> document_ids_;
-	
-	bool IsStopWord(std::string_view word) const;
-
-	static bool IsValidWord(std::string_view word);
-
-	std::vector<std::string_view> SplitIntoWordsNoStop(std::string_view text) const;
-
-	static int ComputeAverageRating(const std::vector<int>& ratings);
-
-	struct QueryWord {
-		std::string_view data;
-		bool is_minus;
-		bool is_stop;
-	};
-
-	QueryWord ParseQueryWord(std::string_view text) const;
-
-	struct Query {
-		std::vector<std::string_view> plus_words;
-		std::vector<std::string_view> minus_words;
-	};
-
-	Query ParseQuery(std::string_view text) const;
-
-	Query ParseQueryNoUniq(std::string_view text) const;
-	
-	double ComputeWordInverseDocumentFreq(std::string_view word) const;
-
-	//sequence version
-	template <typename DocumentPredicate>
-	std::vector<Document> FindAllDocuments(std::string_view raw_query,
-		DocumentPredicate document_predicate) const
-	{
-		std::map<int, double> document_to_relevance;
-		const auto query = ParseQuery(raw_query);
-				
-		for (std::string_view word : query.plus_words) {
-			if (word_to_document_freqs_.count(word) == 0) {
-				continue;
-			}
-			const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-			for (const auto[document_id, term_freq] : word_to_document_freqs_.at(word)) {
-				const auto& document_data = documents_.at(document_id);
-				if (document_predicate(document_id, document_data.status, document_data.rating)) {
-					document_to_relevance[document_id] += term_freq * inverse_document_freq;
-				}
-			}
-		}
-		
-		for (std::string_view word : query.minus_words) {
-			if (word_to_document_freqs_.count(word) == 0) {
-				continue;
-			}
-			for (const auto[document_id, _] : word_to_document_freqs_.at(word)) {
-				document_to_relevance.erase(document_id);
-			}
-		}
-		
-		std::vector<Document> matched_documents;
-		for (const auto[document_id, relevance] : document_to_relevance) {
-			matched_documents.push_back({ document_id, relevance, documents_.at(document_id).rating });
-		}
-		return matched_documents;
-	}
-
-	//parallel version
-	template <typename DocumentPredicate>
-	std::vector<Document> FindAllDocuments(
-		const std::execution::parallel_policy& policy,
-		std::string_view raw_query,
-		DocumentPredicate document_predicate) const
-	{
-		ConcurrentMap<int, double> document_to_relevance(16);
-		const auto query = ParseQuery(raw_query);
-		
-		std::for_each(policy,
-			query.plus_words.begin(), query.plus_words.end(),
-			[this, &document_predicate, &document_to_relevance](std::string_view word)
-		{
-			if (word_to_document_freqs_.count(word)) {
-				const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-				for (const auto[document_id, term_freq] : word_to_document_freqs_.at(word)) {
-					const auto& document_data = documents_.at(document_id);
-					if (document_predicate(document_id, document_data.status, document_data.rating)) {
-						document_to_relevance[document_id].ref_to_value += term_freq * inverse_document_freq;
-					}
-				}
-			}
-		}
-		);
-		
-		std::for_each(policy,
-			query.minus_words.begin(), query.minus_words.end(),
-			[this, &document_to_relevance](std::string_view word)
-		{
-			if (word_to_document_freqs_.count(word)) {
-				for (const auto[document_id, _] : word_to_document_freqs_.at(word)) {
-					document_to_relevance.Erase(document_id);
-				}
-			}
-		});
-
-		std::map<int, double> document_to_relevance_reduced = document_to_relevance.BuildOrdinaryMap();
-		std::vector<Document> matched_documents;
-		matched_documents.reserve(document_to_relevance_reduced.size());
-
-		for (const auto[document_id, relevance] : document_to_relevance_reduced) {
-			matched_documents.push_back({ document_id, relevance, documents_.at(document_id).rating });
-		}
-		
-		return matched_documents;
-	}
-};
+#pragma once
+#include "document.h"
+#include "string_processing.h"
+#include "inverted_index.h"
+#include "memory_stats.h"
+#include "query_parser.h"
+#include "query_cache.h"
+#include "string_arena.h"
+#include "stop_word_filter.h"
+
+#include <exception>
+#include <algorithm>
+#include <cmath>
+#include <tuple>
+#include <map>
+#include <set>
+#include <memory_resource>
+#include <unordered_map>
+#include <execution>
+#include <string_view>
+#include <numeric>
+#include <thread>
+#include <memory>
+#include <mutex>
+#include <future>
+#include <optional>
+#include <type_traits>
+#include <typeinfo>
+#include <queue>
+#include <limits>
+#include <functional>
+
+using std::string_literals::operator""s;
+
+const int MAX_RESULT_DOCUMENT_COUNT = 5;
+const double EPSILON = 1e-6;
+
+// IMMEDIATE removal rewrites the posting lists of the removed documents,
+// DEFERRED removal only marks the documents deleted and leaves their
+// postings to a later compaction
+enum class RemovalMode {
+	IMMEDIATE,
+	DEFERRED,
+};
+
+// What the server keeps to know the words of a document. FULL keeps a map of
+// word frequencies per document; COMPACT keeps a sorted array of (term id,
+// term frequency) pairs per document, several times smaller, and does not
+// reclaim the pairs of removed documents; NONE keeps nothing and tokenizes
+// the stored text again when the words are needed, which makes removal and
+// the word frequency getters slower
+enum class ForwardIndexMode {
+	FULL,
+	COMPACT,
+	NONE,
+};
+
+// Marks a document predicate whose result depends on its arguments only,
+// e.g. a lambda without captures which reads no globals, so its searches may
+// be answered from the query cache. Such a predicate has no state and is
+// identified by its type. Searches with unmarked predicates are not cached
+template <typename Predicate>
+struct CacheablePredicate {
+	static_assert(std::is_empty_v<Predicate>, "A cacheable predicate must have no state");
+
+	Predicate predicate;
+
+	bool operator()(int document_id, DocumentStatus status, int rating) const
+	{
+		return predicate(document_id, status, rating);
+	}
+};
+
+template <typename Predicate>
+CacheablePredicate<Predicate> MakeCacheablePredicate(Predicate predicate)
+{
+	return { predicate };
+}
+
+class SearchServer
+{
+	friend class ConcurrentSearchServer;
+	friend class IndexSnapshot;
+	friend class SegmentedIndex;
+	
+public:
+	// The index, the forward index and the document table take memory from
+	// the resource, e.g. a monotonic_buffer_resource for a bulk build or an
+	// unsynchronized_pool_resource for incremental updates. The resource must
+	// outlive the server. Parallel methods allocate from several threads at
+	// once, so they need a thread safe resource. The background compaction
+	// does not: it only reads the server and builds its copies in the default
+	// resource, and FinishCompaction copies them into the resource of the
+	// server and frees the old arrays on the calling thread
+	template <typename StringContainer>
+	explicit SearchServer(const StringContainer& stop_words,
+		std::pmr::memory_resource* resource = std::pmr::get_default_resource(),
+		ForwardIndexMode forward_index_mode = ForwardIndexMode::FULL)
+		: stop_words_(MakeUniqueNonEmptyStrings(stop_words))  // Extract non-empty stop words
+		, stop_word_filter_(stop_words_)
+		, forward_index_mode_(forward_index_mode)
+		, word_to_document_freqs_(resource)
+		, document_texts_(resource)
+		, document_to_word_freqs_(resource)
+		, document_words_(resource)
+		, document_word_offsets_(resource)
+		, documents_(resource)
+		, document_ordinals_(resource)
+		, document_ids_(resource)
+	{
+		if (!all_of(stop_words_.begin(), stop_words_.end(), IsValidWord)) {
+			throw std::invalid_argument("Some of stop words are invalid"s);
+		}
+		if (forward_index_mode_ == ForwardIndexMode::COMPACT) {
+			document_word_offsets_.push_back(0);
+		}
+	}
+
+	template <typename StringContainer>
+	SearchServer(const StringContainer& stop_words, ForwardIndexMode forward_index_mode,
+		std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+		: SearchServer(stop_words, resource, forward_index_mode) {}
+
+	explicit SearchServer(const std::string& stop_words_text,
+		std::pmr::memory_resource* resource = std::pmr::get_default_resource(),
+		ForwardIndexMode forward_index_mode = ForwardIndexMode::FULL)
+		: SearchServer(SplitIntoWords(stop_words_text), resource, forward_index_mode) {}  // Invoke delegating constructor from string container
+
+	SearchServer(const std::string& stop_words_text, ForwardIndexMode forward_index_mode,
+		std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+		: SearchServer(SplitIntoWords(stop_words_text), resource, forward_index_mode) {}
+
+	// The cache and the running compaction are owned by one server, and the
+	// index points into the arenas of the texts and the terms, so a server is
+	// moved but not copied
+	SearchServer(const SearchServer&) = delete;
+	SearchServer& operator=(const SearchServer&) = delete;
+
+	// finishes the compaction running in other first: its task reads the
+	// members of other
+	SearchServer(SearchServer&& other);
+	
+	void AddDocument(int document_id, std::string_view document,
+		DocumentStatus status, const std::vector<int>& ratings);
+
+	// Bulk load: leaves the index in the same state as AddDocument called for
+	// each document in order. The parallel version tokenizes documents and
+	// fills posting lists concurrently. Throws std::invalid_argument before
+	// changing anything if some id or word is invalid
+	void AddDocuments(const std::vector<RawDocument>& documents);
+
+	void AddDocuments(const std::execution::sequenced_policy& policy,
+		const std::vector<RawDocument>& documents);
+
+	void AddDocuments(const std::execution::parallel_policy& policy,
+		const std::vector<RawDocument>& documents);
+	
+	// Enables the cache of search results for capacity distinct searches,
+	// zero disables it. Searches by status and by predicates marked with
+	// MakeCacheablePredicate are cached; any change of the documents
+	// invalidates the whole cache
+	void SetQueryCacheCapacity(size_t capacity);
+
+	// max_result_count limits the result to the best documents only,
+	// which are selected without sorting the whole match set
+	template <typename DocumentPredicate>
+	std::vector<Document> FindTopDocuments(std::string_view raw_query,
+		DocumentPredicate document_predicate,
+		size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const 
+	{
+		return FindTopDocumentsImpl(std::execution::seq, raw_query, document_predicate,
+			GetPredicateKey(document_predicate), max_result_count);
+	}
+
+	template <typename DocumentPredicate>
+	std::vector<Document> FindTopDocuments(
+		const std::execution::parallel_policy& policy, std::string_view raw_query,
+		DocumentPredicate document_predicate,
+		size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const
+	{		
+		return FindTopDocumentsImpl(policy, raw_query, document_predicate,
+			GetPredicateKey(document_predicate), max_result_count);
+	}
+
+	template <typename DocumentPredicate>
+	std::vector<Document> FindTopDocuments(
+		const std::execution::sequenced_policy& policy, std::string_view raw_query,
+		DocumentPredicate document_predicate,
+		size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const
+	{
+		return FindTopDocuments(raw_query, document_predicate, max_result_count);
+
+	}
+
+	std::vector<Document> FindTopDocuments(std::string_view raw_query,
+		DocumentStatus status,
+		size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const;
+
+	std::vector<Document> FindTopDocuments(
+		const std::execution::parallel_policy& policy, std::string_view raw_query,
+		DocumentStatus status,
+		size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const;
+
+	std::vector<Document> FindTopDocuments(
+		const std::execution::sequenced_policy& policy,
+		std::string_view raw_query, DocumentStatus status,
+		size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const;
+
+	std::vector<Document> FindTopDocuments(std::string_view raw_query) const;
+
+	std::vector<Document> FindTopDocuments(
+		const std::execution::parallel_policy& policy,
+		std::string_view raw_query) const;
+
+	std::vector<Document> FindTopDocuments(
+		const std::execution::sequenced_policy& policy,
+		std::string_view raw_query) const;
+	
+	int GetDocumentCount() const;
+
+	// The reference is valid until the document is removed. In the FULL
+	// forward index mode it is the stored map; in the other modes the map is
+	// built on the first call for the document and kept by the server,
+	// so a scan of all documents is better done with GetWordFrequenciesCopy
+	const std::pmr::map<std::string_view, double>& GetWordFrequencies(int document_id) const;
+
+	// the word frequencies in any forward index mode, built on every call;
+	// the words point into the server
+	std::pmr::map<std::string_view, double> GetWordFrequenciesCopy(int document_id) const;
+
+	ForwardIndexMode GetForwardIndexMode() const;
+
+	// Walks the term table and the document table once, so it is cheap
+	// enough to be exported periodically. Bytes of node based containers
+	// are estimates
+	SearchServerMemoryStats GetMemoryStats() const;
+
+	void RemoveDocument(int document_id);
+
+	template <typename Policy>
+	void RemoveDocument(Policy&& policy, int document_id)
+	{
+		const auto it = document_ordinals_.find(document_id);
+		if (it == document_ordinals_.end()) {
+			return;
+		}
+		const int ordinal = it->second;
+		if (removal_mode_ == RemovalMode::DEFERRED) {
+			RemoveOrdinals(GetRemovalPolicy(policy), { ordinal });
+			return;
+		}
+		FinishCompaction();
+		// every word has its own posting list, so the lists are updated
+		// independently of each other
+		std::vector<std::string_view> words;
+		ForEachDocumentWord(ordinal, [&words](std::string_view word, double) {
+			words.push_back(word);
+		});
+		std::for_each(GetRemovalPolicy(policy), words.begin(), words.end(), [this, ordinal](std::string_view word) {
+			word_to_document_freqs_.Find(word)->Erase(ordinal);
+		});
+		// the slot is never reused, so postings stay sorted by appending
+		if (forward_index_mode_ == ForwardIndexMode::FULL) {
+			document_to_word_freqs_[ordinal].clear();
+		}
+		else {
+			word_freqs_cache_->word_freqs.erase(ordinal);
+		}
+		documents_[ordinal] = DocumentData{};
+		document_ordinals_.erase(it);
+		document_ids_.erase(document_id);
+		OnDocumentsChanged();
+	}
+
+	// Removes many documents at once: every affected posting list is
+	// rewritten in a single pass instead of once per removed document.
+	// Unknown ids are ignored
+	template <typename DocumentIdRange>
+	void RemoveDocuments(const DocumentIdRange& document_ids)
+	{
+		RemoveDocuments(std::execution::seq, document_ids);
+	}
+
+	template <typename Policy, typename DocumentIdRange>
+	void RemoveDocuments(Policy&& policy, const DocumentIdRange& document_ids)
+	{
+		std::vector<int> ordinals;
+		for (const int document_id : document_ids) {
+			const auto it = document_ordinals_.find(document_id);
+			if (it != document_ordinals_.end()) {
+				ordinals.push_back(it->second);
+			}
+		}
+		RemoveOrdinals(GetRemovalPolicy(policy), std::move(ordinals));
+	}
+
+	void SetRemovalMode(RemovalMode mode);
+
+	// Documents removed in the DEFERRED mode are hidden from every query at
+	// once, but their postings are reclaimed by compaction. StartCompaction
+	// rebuilds the affected posting lists in a background thread; queries and
+	// deferred removals may go on meanwhile, the result is applied by
+	// TryFinishCompaction or FinishCompaction, which also drop the words of
+	// the compacted documents. Any other change of the documents finishes a
+	// running compaction first
+	void StartCompaction();
+
+	// applies the compaction result if it is ready,
+	// returns true if no compaction is running any more
+	bool TryFinishCompaction();
+
+	// waits for the running compaction, if any, and applies its result
+	void FinishCompaction();
+
+	bool IsCompactionRunning() const;
+
+	// Compresses every posting list: ids become varint gaps and term
+	// frequencies indexes into a per-list table, which takes several times
+	// less memory and gives the same search results. A list whose compressed
+	// form would not be smaller stays plain. Meant for read-mostly
+	// indexes: a list touched by AddDocument or an immediate removal is
+	// decoded back and stays plain until the next call
+	void CompressPostings();
+
+	void CompressPostings(const std::execution::sequenced_policy& policy);
+
+	void CompressPostings(const std::execution::parallel_policy& policy);
+
+	// removed documents whose postings are not reclaimed yet,
+	// including the ones of the running compaction
+	size_t GetDeletedDocumentCount() const;
+
+	const std::pmr::set<int>::const_iterator begin() const;
+
+	const std::pmr::set<int>::const_iterator end() const;
+
+	std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(
+		std::string_view raw_query, int document_id) const;
+
+	std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(
+		const std::execution::parallel_policy& policy, 
+		std::string_view raw_query, int document_id) const;
+
+	std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(
+		const std::execution::sequenced_policy& policy, 
+		std::string_view raw_query, int document_id) const;
+
+private:
+	struct DocumentData {
+		int id = -1;
+		int rating = 0;
+		DocumentStatus status = DocumentStatus::REMOVED;
+		// points into document_texts_
+		std::string_view data;
+	};
+	// maps returned by GetWordFrequencies in the COMPACT and NONE modes, by
+	// ordinal; it is a const method, so they are built under the mutex and
+	// taken from the default resource, which is thread safe
+	struct WordFrequenciesCache {
+		std::mutex mutex;
+		std::unordered_map<int, std::pmr::map<std::string_view, double>> word_freqs;
+	};
+	// an entry of the COMPACT forward index
+	struct DocumentWord {
+		uint32_t term_id = 0;
+		double term_freq = 0.0;
+	};
+	const std::set<std::string, std::less<>> stop_words_;
+	// the same words in a form checked in O(1) per token
+	const StopWordFilter stop_word_filter_;
+	const ForwardIndexMode forward_index_mode_;
+	InvertedIndex word_to_document_freqs_;
+	// texts of all documents ever added, removal does not reclaim them
+	StringArena document_texts_;
+	// documents are addressed by a dense ordinal assigned in insertion order;
+	// posting lists and the tables below are indexed by it, and the external id
+	// is translated only on entry and on output
+	// the forward index: filled in the FULL mode only
+	std::pmr::vector<std::pmr::map<std::string_view, double>> document_to_word_freqs_;
+	// the COMPACT one: words of the ordinal i are document_words_ from
+	// document_word_offsets_[i] to document_word_offsets_[i + 1], by term id
+	std::pmr::vector<DocumentWord> document_words_;
+	std::pmr::vector<size_t> document_word_offsets_;
+	std::pmr::vector<DocumentData> documents_;
+	std::pmr::unordered_map<int, int> document_ordinals_;
+	std::pmr::set<int> document_ids_;
+	// idf of a term is log(N / df) = log(N) - log(df); both logarithms are
+	// maintained on index changes, so a query only subtracts them
+	double log_document_count_ = 0.0;
+	// bumped on every change of the documents
+	uint64_t generation_ = 0;
+	std::unique_ptr<QueryCache> query_cache_;
+	std::unique_ptr<WordFrequenciesCache> word_freqs_cache_ = std::make_unique<WordFrequenciesCache>();
+	RemovalMode removal_mode_ = RemovalMode::IMMEDIATE;
+	// documents removed in the DEFERRED mode, indexed by ordinal
+	std::vector<bool> tombstones_;
+	// removed ordinals waiting for compaction and the ones being compacted now
+	std::vector<int> pending_tombstones_;
+	std::vector<int> compacting_ordinals_;
+	// compacted copies of posting lists built in the background; declared last,
+	// so the destructor waits for the task before anything it reads is destroyed
+	std::future<std::vector<std::pair<PostingList*, PostingList>>> compaction_;
+
+	struct CompactionFinished {};
+
+	static CompactionFinished FinishCompactionOf(SearchServer& search_server);
+
+	// moves the members, other must have no running compaction
+	SearchServer(SearchServer&& other, CompactionFinished);
+	
+	bool IsStopWord(std::string_view word) const;
+
+	static bool IsValidWord(std::string_view word);
+
+	std::vector<std::string_view> SplitIntoWordsNoStop(std::string_view text) const;
+
+	// distinct words with their term frequencies, sorted by word
+	static std::vector<std::pair<std::string_view, double>> ComputeWordFrequencies(
+		std::vector<std::string_view> words);
+
+	// appends the next document to the COMPACT forward index,
+	// the words must be in the index already
+	void AppendDocumentWords(const std::vector<std::pair<std::string_view, double>>& word_freqs);
+
+	// calls visitor(word, term_freq) for every word of the document
+	template <typename Visitor>
+	void ForEachDocumentWord(int ordinal, Visitor visitor) const
+	{
+		if (forward_index_mode_ == ForwardIndexMode::FULL) {
+			for (const auto& [word, term_freq] : document_to_word_freqs_[ordinal]) {
+				visitor(word, term_freq);
+			}
+		}
+		else if (forward_index_mode_ == ForwardIndexMode::COMPACT) {
+			for (size_t i = document_word_offsets_[ordinal]; i < document_word_offsets_[ordinal + 1]; ++i) {
+				visitor(word_to_document_freqs_.GetTerm(document_words_[i].term_id), document_words_[i].term_freq);
+			}
+		}
+		else {
+			for (const auto& [word, term_freq] : ComputeWordFrequencies(SplitIntoWordsNoStop(documents_[ordinal].data))) {
+				visitor(word, term_freq);
+			}
+		}
+	}
+
+	static int ComputeAverageRating(const std::vector<int>& ratings);
+
+	template <typename ExecutionPolicy>
+	void AddDocumentsImpl(ExecutionPolicy&& policy, const std::vector<RawDocument>& documents);
+
+	std::vector<std::pair<PostingList*, PostingList>> CompactPostings(const std::vector<int>& ordinals);
+
+	template <typename ExecutionPolicy>
+	void CompressPostingsImpl(ExecutionPolicy&& policy);
+
+	// the policy a removal runs with: erasing allocates, which an unsequenced
+	// algorithm must not do, so par_unseq runs as par and other policies as seq
+	template <typename Policy>
+	static const auto& GetRemovalPolicy(const Policy&)
+	{
+		if constexpr (std::is_same_v<Policy, std::execution::parallel_policy>
+			|| std::is_same_v<Policy, std::execution::parallel_unsequenced_policy>) {
+			return std::execution::par;
+		}
+		else {
+			return std::execution::seq;
+		}
+	}
+
+	void RemoveOrdinals(const std::execution::sequenced_policy& policy, std::vector<int> ordinals);
+
+	void RemoveOrdinals(const std::execution::parallel_policy& policy, std::vector<int> ordinals);
+
+	template <typename ExecutionPolicy>
+	void RemoveOrdinalsImpl(ExecutionPolicy&& policy, std::vector<int> ordinals);
+
+	Query ParseQuery(std::string_view text) const;
+
+	Query ParseQueryNoUniq(std::string_view text) const;
+	
+	double ComputeWordInverseDocumentFreq(const PostingList& postings) const;
+
+	// must be called after every change of the documents
+	void OnDocumentsChanged();
+
+	// smallest number of ordinals scored by one task of the parallel search
+	static constexpr int MIN_PARALLEL_RANGE_SIZE = 2048;
+
+	// relevance descending, ties within EPSILON broken by rating descending
+	static bool IsMoreRelevant(const Document& lhs, const Document& rhs);
+
+	// leaves only the max_result_count best documents, ordered by IsMoreRelevant
+	template <typename ExecutionPolicy>
+	static void SelectTopDocuments(ExecutionPolicy&& policy,
+		std::vector<Document>& documents, size_t max_result_count)
+	{
+		if (documents.size() > max_result_count) {
+			std::partial_sort(policy, documents.begin(),
+				documents.begin() + max_result_count, documents.end(), IsMoreRelevant);
+			documents.resize(max_result_count);
+		}
+		else {
+			std::sort(policy, documents.begin(), documents.end(), IsMoreRelevant);
+		}
+	}
+
+	// a predicate may read anything besides its arguments,
+	// so only the marked ones are cached
+	template <typename DocumentPredicate>
+	static std::optional<QueryCache::PredicateKey> GetPredicateKey(const DocumentPredicate&)
+	{
+		return std::nullopt;
+	}
+
+	template <typename Predicate>
+	static std::optional<QueryCache::PredicateKey> GetPredicateKey(const CacheablePredicate<Predicate>&)
+	{
+		return QueryCache::PredicateKey{ typeid(Predicate) };
+	}
+
+	static QueryCache::PredicateKey GetPredicateKey(DocumentStatus status);
+
+	template <typename ExecutionPolicy, typename DocumentPredicate>
+	std::vector<Document> FindTopDocumentsImpl(ExecutionPolicy&& policy,
+		std::string_view raw_query, DocumentPredicate document_predicate,
+		const std::optional<QueryCache::PredicateKey>& predicate_key,
+		size_t max_result_count) const
+	{
+		const auto query = ParseQuery(raw_query);
+		std::optional<QueryCache::Key> cache_key;
+		if (query_cache_ && predicate_key) {
+			cache_key = QueryCache::MakeKey(query, *predicate_key, max_result_count);
+			if (auto cached_documents = query_cache_->Find(*cache_key, generation_)) {
+				return *std::move(cached_documents);
+			}
+		}
+		std::vector<Document> matched_documents;
+		if (std::is_same_v<std::decay_t<ExecutionPolicy>, std::execution::sequenced_policy>
+			&& query.plus_words.size() > 1) {
+			matched_documents = FindTopDocumentsPruned(query, document_predicate, max_result_count);
+		}
+		else {
+			matched_documents = FindAllDocuments(policy, query, document_predicate);
+			SelectTopDocuments(policy, matched_documents, max_result_count);
+		}
+		if (cache_key) {
+			query_cache_->Insert(*std::move(cache_key), generation_, matched_documents);
+		}
+		return matched_documents;
+	}
+
+	// Document-at-a-time MaxScore evaluation of a multi-word query. Terms are
+	// ordered by the upper bound of their score, max term frequency * idf.
+	// Once max_result_count documents are found, the terms whose bounds sum
+	// up to less than the current threshold cannot bring a new document to
+	// the top on their own: only the other terms produce candidates, the weak
+	// ones are looked up for these candidates only, and a candidate is dropped
+	// as soon as its bound falls below the threshold.
+	// The threshold stays EPSILON below the last top relevance, so documents
+	// which could win on rating are kept, and the relevance of a kept
+	// document is summed in query word order: the result equals the one of
+	// FindAllDocuments and SelectTopDocuments
+	template <typename DocumentPredicate>
+	std::vector<Document> FindTopDocumentsPruned(const Query& query,
+		DocumentPredicate document_predicate, size_t max_result_count) const
+	{
+		struct TermCursor {
+			PostingCursor cursor;
+			size_t word_index = 0;
+			double max_score = 0.0;
+		};
+		std::vector<TermCursor> terms;
+		std::vector<double> inverse_document_freqs(query.plus_words.size(), 0.0);
+		for (size_t word_index = 0; word_index < query.plus_words.size(); ++word_index) {
+			const PostingList* postings = word_to_document_freqs_.Find(query.plus_words[word_index]);
+			if (postings == nullptr || postings->GetDocumentFreq() == 0) {
+				continue;
+			}
+			inverse_document_freqs[word_index] = ComputeWordInverseDocumentFreq(*postings);
+			terms.push_back({ PostingCursor(*postings), word_index,
+				postings->GetMaxTermFreq() * inverse_document_freqs[word_index] });
+		}
+		std::vector<PostingCursor> minus_cursors;
+		for (std::string_view word : query.minus_words) {
+			const PostingList* postings = word_to_document_freqs_.Find(word);
+			if (postings != nullptr && !postings->empty()) {
+				minus_cursors.emplace_back(*postings);
+			}
+		}
+		if (max_result_count == 0 || terms.empty()) {
+			return {};
+		}
+
+		std::sort(terms.begin(), terms.end(), [](const TermCursor& lhs, const TermCursor& rhs) {
+			return lhs.max_score < rhs.max_score;
+		});
+		// bound of a document found in the terms [0, i) only
+		std::vector<double> max_score_prefixes(terms.size() + 1, 0.0);
+		for (size_t i = 0; i < terms.size(); ++i) {
+			max_score_prefixes[i + 1] = max_score_prefixes[i] + terms[i].max_score;
+		}
+		// terms before the first essential one are looked up, not walked
+		size_t first_essential = 0;
+		double threshold = -std::numeric_limits<double>::infinity();
+		std::priority_queue<double, std::vector<double>, std::greater<>> top_relevances;
+
+		std::vector<Document> matched_documents;
+		std::vector<double> term_freqs(query.plus_words.size(), 0.0);
+		while (true) {
+			int ordinal = std::numeric_limits<int>::max();
+			for (size_t i = first_essential; i < terms.size(); ++i) {
+				if (!terms[i].cursor.IsEnd()) {
+					ordinal = std::min(ordinal, terms[i].cursor.GetDocumentId());
+				}
+			}
+			if (ordinal == std::numeric_limits<int>::max()) {
+				break;
+			}
+
+			std::fill(term_freqs.begin(), term_freqs.end(), 0.0);
+			double score = 0.0;
+			for (size_t i = first_essential; i < terms.size(); ++i) {
+				PostingCursor& cursor = terms[i].cursor;
+				if (!cursor.IsEnd() && cursor.GetDocumentId() == ordinal) {
+					term_freqs[terms[i].word_index] = cursor.GetTermFreq();
+					score += cursor.GetTermFreq() * inverse_document_freqs[terms[i].word_index];
+					cursor.Next();
+				}
+			}
+			bool is_pruned = false;
+			for (size_t i = first_essential; i-- > 0;) {
+				if (score + max_score_prefixes[i + 1] < threshold) {
+					is_pruned = true;
+					break;
+				}
+				PostingCursor& cursor = terms[i].cursor;
+				cursor.Advance(ordinal);
+				if (!cursor.IsEnd() && cursor.GetDocumentId() == ordinal) {
+					term_freqs[terms[i].word_index] = cursor.GetTermFreq();
+					score += cursor.GetTermFreq() * inverse_document_freqs[terms[i].word_index];
+				}
+			}
+			if (is_pruned || score < threshold || tombstones_[ordinal]) {
+				continue;
+			}
+			const bool is_excluded = std::any_of(minus_cursors.begin(), minus_cursors.end(),
+				[ordinal](PostingCursor& cursor) {
+				cursor.Advance(ordinal);
+				return !cursor.IsEnd() && cursor.GetDocumentId() == ordinal;
+			});
+			const auto& document_data = documents_[ordinal];
+			if (is_excluded || !document_predicate(document_data.id, document_data.status, document_data.rating)) {
+				continue;
+			}
+
+			double relevance = 0.0;
+			for (size_t word_index = 0; word_index < term_freqs.size(); ++word_index) {
+				if (term_freqs[word_index] > 0.0) {
+					relevance += term_freqs[word_index] * inverse_document_freqs[word_index];
+				}
+			}
+			matched_documents.push_back({ document_data.id, relevance, document_data.rating });
+			top_relevances.push(relevance);
+			if (top_relevances.size() > max_result_count) {
+				top_relevances.pop();
+			}
+			if (top_relevances.size() == max_result_count) {
+				threshold = top_relevances.top() - EPSILON;
+				while (first_essential < terms.size() && max_score_prefixes[first_essential + 1] < threshold) {
+					++first_essential;
+				}
+			}
+		}
+		SelectTopDocuments(std::execution::seq, matched_documents, max_result_count);
+		return matched_documents;
+	}
+
+	// Dense per-ordinal arrays of the sequential search. Every thread keeps
+	// its own and reuses it for all queries; between queries all entries are
+	// zero and unseen, and a query resets only the entries it has touched
+	struct ScoreScratch {
+		enum : char { UNSEEN, ACCEPTED, REJECTED };
+		std::vector<double> relevance;
+		std::vector<char> state;
+		std::vector<int> touched;
+		bool is_used = false;
+
+		void Reset();
+	};
+
+	static ScoreScratch& GetThreadScoreScratch();
+
+	//sequence version
+	template <typename DocumentPredicate>
+	std::vector<Document> FindAllDocuments(
+		const std::execution::sequenced_policy&,
+		const Query& query,
+		DocumentPredicate document_predicate) const
+	{
+		ScoreScratch& thread_scratch = GetThreadScoreScratch();
+		ScoreScratch own_scratch;
+		// the predicate may run another search on the same thread
+		ScoreScratch& scratch = thread_scratch.is_used ? own_scratch : thread_scratch;
+		scratch.is_used = true;
+		if (scratch.state.size() < documents_.size()) {
+			scratch.relevance.resize(documents_.size(), 0.0);
+			scratch.state.resize(documents_.size(), ScoreScratch::UNSEEN);
+		}
+		auto& relevance = scratch.relevance;
+		auto& state = scratch.state;
+		auto& touched = scratch.touched;
+
+		std::vector<Document> matched_documents;
+		try {
+			for (std::string_view word : query.minus_words) {
+				const PostingList* postings = word_to_document_freqs_.Find(word);
+				if (postings == nullptr) {
+					continue;
+				}
+				postings->ForEach([&state, &touched](int ordinal, double) {
+					if (state[ordinal] == ScoreScratch::UNSEEN) {
+						state[ordinal] = ScoreScratch::REJECTED;
+						touched.push_back(ordinal);
+					}
+				});
+			}
+
+			for (std::string_view word : query.plus_words) {
+				const PostingList* postings = word_to_document_freqs_.Find(word);
+				if (postings == nullptr || postings->GetDocumentFreq() == 0) {
+					continue;
+				}
+				const double inverse_document_freq = ComputeWordInverseDocumentFreq(*postings);
+				postings->ForEach([&](int ordinal, double term_freq) {
+					if (state[ordinal] == ScoreScratch::UNSEEN) {
+						const auto& document_data = documents_[ordinal];
+						state[ordinal] = !tombstones_[ordinal]
+							&& document_predicate(document_data.id, document_data.status, document_data.rating)
+							? ScoreScratch::ACCEPTED : ScoreScratch::REJECTED;
+						touched.push_back(ordinal);
+					}
+					if (state[ordinal] == ScoreScratch::ACCEPTED) {
+						relevance[ordinal] += term_freq * inverse_document_freq;
+					}
+				});
+			}
+
+			for (const int ordinal : touched) {
+				if (state[ordinal] == ScoreScratch::ACCEPTED) {
+					const auto& document_data = documents_[ordinal];
+					matched_documents.push_back({ document_data.id, relevance[ordinal], document_data.rating });
+				}
+			}
+		}
+		catch (...) {
+			scratch.Reset();
+			throw;
+		}
+		scratch.Reset();
+		return matched_documents;
+	}
+
+	//parallel version
+	template <typename DocumentPredicate>
+	std::vector<Document> FindAllDocuments(
+		const std::execution::parallel_policy& policy,
+		const Query& query,
+		DocumentPredicate document_predicate) const
+	{
+
+		std::vector<std::pair<const PostingList*, double>> plus_postings;
+		for (std::string_view word : query.plus_words) {
+			const PostingList* postings = word_to_document_freqs_.Find(word);
+			if (postings != nullptr && postings->GetDocumentFreq() > 0) {
+				plus_postings.emplace_back(postings, ComputeWordInverseDocumentFreq(*postings));
+			}
+		}
+		std::vector<const PostingList*> minus_postings;
+		for (std::string_view word : query.minus_words) {
+			const PostingList* postings = word_to_document_freqs_.Find(word);
+			if (postings != nullptr && !postings->empty()) {
+				minus_postings.push_back(postings);
+			}
+		}
+
+		// the ordinal space is cut into ranges and every range is scored
+		// by a single task into its own dense arrays, so tasks share nothing
+		// and results are merged by concatenation
+		const int ordinal_count = static_cast<int>(documents_.size());
+		const int range_count = std::clamp(ordinal_count / MIN_PARALLEL_RANGE_SIZE, 1,
+			static_cast<int>(std::max(1u, std::thread::hardware_concurrency())) * 4);
+		const int range_size = (ordinal_count + range_count - 1) / range_count;
+
+		std::vector<int> ranges(range_count);
+		std::iota(ranges.begin(), ranges.end(), 0);
+		std::vector<std::vector<Document>> range_documents(range_count);
+
+		std::for_each(policy, ranges.begin(), ranges.end(),
+			[this, &document_predicate, &plus_postings, &minus_postings, &range_documents,
+			range_size, ordinal_count](int range)
+		{
+			enum : char { UNSEEN, ACCEPTED, REJECTED };
+			const int first_ordinal = range * range_size;
+			const int last_ordinal = std::min(first_ordinal + range_size, ordinal_count);
+			if (first_ordinal >= last_ordinal) {
+				return;
+			}
+			std::vector<double> relevance(last_ordinal - first_ordinal, 0.0);
+			std::vector<char> state(last_ordinal - first_ordinal, UNSEEN);
+
+			for (const PostingList* postings : minus_postings) {
+				postings->ForEachInRange(first_ordinal, last_ordinal, [&state, first_ordinal](int ordinal, double) {
+					state[ordinal - first_ordinal] = REJECTED;
+				});
+			}
+
+			for (const auto& [postings, inverse_document_freq] : plus_postings) {
+				postings->ForEachInRange(first_ordinal, last_ordinal, [&, inverse_document_freq = inverse_document_freq](int ordinal, double term_freq) {
+					const int slot = ordinal - first_ordinal;
+					if (state[slot] == UNSEEN) {
+						const auto& document_data = documents_[ordinal];
+						state[slot] = !tombstones_[ordinal]
+							&& document_predicate(document_data.id, document_data.status, document_data.rating)
+							? ACCEPTED : REJECTED;
+					}
+					if (state[slot] == ACCEPTED) {
+						relevance[slot] += term_freq * inverse_document_freq;
+					}
+				});
+			}
+
+			auto& matched_documents = range_documents[range];
+			for (int slot = 0; slot < last_ordinal - first_ordinal; ++slot) {
+				if (state[slot] == ACCEPTED) {
+					const auto& document_data = documents_[first_ordinal + slot];
+					matched_documents.push_back({ document_data.id, relevance[slot], document_data.rating });
+				}
+			}
+		});
+
+		size_t matched_count = 0;
+		for (const auto& documents : range_documents) {
+			matched_count += documents.size();
+		}
+		std::vector<Document> matched_documents;
+		matched_documents.reserve(matched_count);
+		for (const auto& documents : range_documents) {
+			matched_documents.insert(matched_documents.end(), documents.begin(), documents.end());
+		}
+		return matched_documents;
+	}
+};
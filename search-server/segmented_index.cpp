@@ -0,0 +1,594 @@
+#include "segmented_index.h"
+#include "inverted_index.h"
+
+#include <functional>
+#include <numeric>
+#include <stdexcept>
+#include <unordered_map>
+
+struct SegmentedIndex::SealedSegment {
+	std::vector<DocumentEntry> documents;
+	std::unordered_map<int, int> ordinals;
+	// term strings are never moved after the dictionary is built
+	std::vector<std::string> terms;
+	std::unordered_map<std::string_view, int> term_indexes;
+	// postings of term t are [posting_offsets[t], posting_offsets[t + 1])
+	std::vector<size_t> posting_offsets;
+	std::vector<int> posting_ordinals;
+	std::vector<double> posting_term_freqs;
+	// term indexes of every document, needed to count deletions per term
+	std::vector<size_t> document_term_offsets;
+	std::vector<int> document_terms;
+
+	// returns -1 if the segment has no such term
+	int FindTermIndex(std::string_view word) const
+	{
+		const auto it = term_indexes.find(word);
+		return it == term_indexes.end() ? -1 : it->second;
+	}
+
+	bool Contains(std::string_view word, int ordinal) const
+	{
+		const int term_index = FindTermIndex(word);
+		return term_index >= 0 && std::binary_search(
+			posting_ordinals.begin() + posting_offsets[term_index],
+			posting_ordinals.begin() + posting_offsets[term_index + 1], ordinal);
+	}
+
+	template <typename TermPostingLists>
+	void Fill(const TermPostingLists& term_postings);
+};
+
+struct SegmentedIndex::SealedSegmentState {
+	std::shared_ptr<const SealedSegment> segment;
+	std::vector<bool> deleted;
+	std::vector<int> deleted_term_counts;
+	size_t deleted_count = 0;
+
+	explicit SealedSegmentState(std::shared_ptr<const SealedSegment> sealed_segment)
+		: segment(std::move(sealed_segment))
+		, deleted(segment->documents.size(), false)
+		, deleted_term_counts(segment->terms.size(), 0)
+	{
+	}
+
+	size_t GetLiveDocumentCount() const
+	{
+		return segment->documents.size() - deleted_count;
+	}
+
+	void MarkDeleted(int ordinal)
+	{
+		deleted[ordinal] = true;
+		++deleted_count;
+		for (size_t i = segment->document_term_offsets[ordinal]; i < segment->document_term_offsets[ordinal + 1]; ++i) {
+			++deleted_term_counts[segment->document_terms[i]];
+		}
+	}
+};
+
+struct SegmentedIndex::MutableSegment {
+	InvertedIndex index;
+	std::vector<DocumentEntry> documents;
+	// interned terms of every document
+	std::vector<std::vector<std::string_view>> document_terms;
+	std::unordered_map<int, int> ordinals;
+	std::vector<bool> deleted;
+};
+
+namespace {
+
+// postings of one term sorted by ordinal, the term is viewed
+// in the segment it came from
+using TermPostingList = std::pair<std::string_view, std::vector<std::pair<int, double>>>;
+
+}  // namespace
+
+// builds the dictionary, postings and forward terms, documents must be set
+template <typename TermPostingLists>
+void SegmentedIndex::SealedSegment::Fill(const TermPostingLists& term_postings)
+{
+	const size_t document_count = documents.size();
+	terms.reserve(term_postings.size());
+	posting_offsets.reserve(term_postings.size() + 1);
+	posting_offsets.push_back(0);
+	std::vector<size_t> document_term_counts(document_count + 1, 0);
+	for (const auto& [term, postings] : term_postings) {
+		terms.emplace_back(term);
+		for (const auto& [ordinal, term_freq] : postings) {
+			posting_ordinals.push_back(ordinal);
+			posting_term_freqs.push_back(term_freq);
+			++document_term_counts[ordinal + 1];
+		}
+		posting_offsets.push_back(posting_ordinals.size());
+	}
+	term_indexes.reserve(terms.size());
+	for (size_t index = 0; index < terms.size(); ++index) {
+		term_indexes.emplace(terms[index], static_cast<int>(index));
+	}
+
+	std::partial_sum(document_term_counts.begin(), document_term_counts.end(), document_term_counts.begin());
+	document_term_offsets = document_term_counts;
+	document_terms.resize(posting_ordinals.size());
+	for (size_t term_index = 0; term_index < terms.size(); ++term_index) {
+		for (size_t i = posting_offsets[term_index]; i < posting_offsets[term_index + 1]; ++i) {
+			document_terms[document_term_counts[posting_ordinals[i]]++] = static_cast<int>(term_index);
+		}
+	}
+	for (size_t ordinal = 0; ordinal < document_count; ++ordinal) {
+		ordinals.emplace(documents[ordinal].id, static_cast<int>(ordinal));
+	}
+}
+
+SegmentedIndex::SegmentedIndex(const std::string& stop_words_text,
+	const SegmentedIndexOptions& options)
+	: SegmentedIndex(options, MakeUniqueNonEmptyStrings(SplitIntoWords(stop_words_text)))
+{
+}
+
+SegmentedIndex::SegmentedIndex(const SegmentedIndexOptions& options,
+	std::set<std::string, std::less<>> stop_words)
+	: stop_words_(std::move(stop_words))
+	, stop_word_filter_(stop_words_)
+	, options_(options)
+	, mutable_segment_(std::make_unique<MutableSegment>())
+{
+	if (std::any_of(stop_words_.begin(), stop_words_.end(), ContainsControlChars)) {
+		throw std::invalid_argument("Some of stop words are invalid"s);
+	}
+	if (options_.max_mutable_document_count == 0 || options_.merge_factor < 2) {
+		throw std::invalid_argument("Invalid segmented index options"s);
+	}
+}
+
+SegmentedIndex::~SegmentedIndex()
+{
+	std::shared_future<void> merger;
+	{
+		std::lock_guard guard(mutex_);
+		merger = merger_;
+	}
+	if (merger.valid()) {
+		merger.wait();
+	}
+}
+
+void SegmentedIndex::AddDocument(int document_id, std::string_view document,
+	DocumentStatus status, const std::vector<int>& ratings)
+{
+	std::vector<std::string_view> words;
+	const bool is_valid_text = !ContainsControlChars(document);
+	for (std::string_view word : SplitIntoWords(document)) {
+		if (!is_valid_text && ContainsControlChars(word)) {
+			throw std::invalid_argument("Word "s + std::string(word) + " is invalid"s);
+		}
+		if (!IsStopWord(word)) {
+			words.push_back(word);
+		}
+	}
+	const int rating = SearchServer::ComputeAverageRating(ratings);
+
+	std::unique_lock lock(mutex_);
+	if (document_id < 0 || ContainsDocument(document_id)) {
+		throw std::invalid_argument("Invalid document_id"s);
+	}
+	MutableSegment& segment = *mutable_segment_;
+	const int ordinal = static_cast<int>(segment.documents.size());
+	segment.documents.push_back({ document_id, rating, status });
+	segment.deleted.push_back(false);
+	segment.ordinals.emplace(document_id, ordinal);
+
+	// accumulated the same way SearchServer does to get equal relevance
+	const double inv_word_count = 1.0 / words.size();
+	auto& terms = segment.document_terms.emplace_back();
+	for (std::string_view word : words) {
+		auto [term, postings] = segment.index.Insert(word);
+		if (!postings.Contains(ordinal)) {
+			terms.push_back(term);
+		}
+		postings.AddTermFreq(ordinal, inv_word_count);
+	}
+	++document_count_;
+
+	if (segment.documents.size() >= options_.max_mutable_document_count) {
+		std::shared_ptr<MutableSegment> full_segment = DetachMutableSegment();
+		lock.unlock();
+		if (full_segment) {
+			SealSegment(std::move(full_segment));
+		}
+	}
+}
+
+void SegmentedIndex::RemoveDocument(int document_id)
+{
+	std::lock_guard guard(mutex_);
+	std::vector<MutableSegment*> mutable_segments = { mutable_segment_.get() };
+	for (const auto& segment : sealing_segments_) {
+		mutable_segments.push_back(segment.get());
+	}
+	for (MutableSegment* segment : mutable_segments) {
+		if (const auto it = segment->ordinals.find(document_id); it != segment->ordinals.end()) {
+			segment->deleted[it->second] = true;
+			for (std::string_view term : segment->document_terms[it->second]) {
+				segment->index.Find(term)->MarkDeleted(1);
+			}
+			segment->ordinals.erase(it);
+			--document_count_;
+			return;
+		}
+	}
+	for (SealedSegmentState& state : sealed_segments_) {
+		const auto it = state.segment->ordinals.find(document_id);
+		if (it != state.segment->ordinals.end() && !state.deleted[it->second]) {
+			state.MarkDeleted(it->second);
+			--document_count_;
+			return;
+		}
+	}
+}
+
+std::vector<Document> SegmentedIndex::FindTopDocuments(std::string_view raw_query,
+	DocumentStatus status, size_t max_result_count) const
+{
+	return FindTopDocuments(std::execution::seq, raw_query, status, max_result_count);
+}
+
+std::vector<Document> SegmentedIndex::FindTopDocuments(
+	const std::execution::sequenced_policy& policy, std::string_view raw_query,
+	DocumentStatus status, size_t max_result_count) const
+{
+	return FindTopDocumentsImpl(policy, raw_query,
+		[status](int, DocumentStatus document_status, int) {
+		return document_status == status;
+	}, max_result_count);
+}
+
+std::vector<Document> SegmentedIndex::FindTopDocuments(
+	const std::execution::parallel_policy& policy, std::string_view raw_query,
+	DocumentStatus status, size_t max_result_count) const
+{
+	return FindTopDocumentsImpl(policy, raw_query,
+		[status](int, DocumentStatus document_status, int) {
+		return document_status == status;
+	}, max_result_count);
+}
+
+std::tuple<std::vector<std::string_view>, DocumentStatus> SegmentedIndex::MatchDocument(
+	std::string_view raw_query, int document_id) const
+{
+	const auto query = ParseQuery(raw_query, [this](std::string_view word) {
+		return IsStopWord(word);
+	});
+
+	std::shared_lock lock(mutex_);
+	// finds the segment of the document and checks the word in it
+	std::function<bool(std::string_view)> contains;
+	DocumentStatus status = DocumentStatus::ACTUAL;
+	std::vector<const MutableSegment*> mutable_segments = { mutable_segment_.get() };
+	for (const auto& segment : sealing_segments_) {
+		mutable_segments.push_back(segment.get());
+	}
+	for (const MutableSegment* segment : mutable_segments) {
+		const auto it = segment->ordinals.find(document_id);
+		if (!contains && it != segment->ordinals.end()) {
+			status = segment->documents[it->second].status;
+			contains = [segment, ordinal = it->second](std::string_view word) {
+				const PostingList* postings = segment->index.Find(word);
+				return postings != nullptr && postings->Contains(ordinal);
+			};
+		}
+	}
+	for (const SealedSegmentState& state : sealed_segments_) {
+		const auto it = state.segment->ordinals.find(document_id);
+		if (!contains && it != state.segment->ordinals.end() && !state.deleted[it->second]) {
+			status = state.segment->documents[it->second].status;
+			contains = [&state, ordinal = it->second](std::string_view word) {
+				return state.segment->Contains(word, ordinal);
+			};
+		}
+	}
+	if (!contains) {
+		throw std::out_of_range("Document "s + std::to_string(document_id) + " is not in the index"s);
+	}
+
+	std::vector<std::string_view> matched_words;
+	if (std::any_of(query.minus_words.begin(), query.minus_words.end(), contains)) {
+		return { matched_words, status };
+	}
+	std::copy_if(query.plus_words.begin(), query.plus_words.end(),
+		std::back_inserter(matched_words), contains);
+	return { matched_words, status };
+}
+
+int SegmentedIndex::GetDocumentCount() const
+{
+	std::shared_lock lock(mutex_);
+	return document_count_;
+}
+
+size_t SegmentedIndex::GetSealedSegmentCount() const
+{
+	std::shared_lock lock(mutex_);
+	return sealed_segments_.size();
+}
+
+void SegmentedIndex::Seal()
+{
+	std::shared_ptr<MutableSegment> segment;
+	{
+		std::lock_guard guard(mutex_);
+		segment = DetachMutableSegment();
+	}
+	if (segment) {
+		SealSegment(std::move(segment));
+	}
+}
+
+void SegmentedIndex::WaitForMerges()
+{
+	while (true) {
+		std::shared_future<void> merger;
+		{
+			std::shared_lock lock(mutex_);
+			merger = merger_;
+		}
+		if (!merger.valid()) {
+			return;
+		}
+		merger.get();
+		// a merge could have been started again while waiting
+		std::shared_lock lock(mutex_);
+		if (!is_merging_) {
+			return;
+		}
+	}
+}
+
+bool SegmentedIndex::IsStopWord(std::string_view word) const
+{
+	return stop_word_filter_.Contains(word);
+}
+
+bool SegmentedIndex::ContainsDocument(int document_id) const
+{
+	if (mutable_segment_->ordinals.count(document_id) > 0
+		|| std::any_of(sealing_segments_.begin(), sealing_segments_.end(),
+			[document_id](const auto& segment) { return segment->ordinals.count(document_id) > 0; })) {
+		return true;
+	}
+	return std::any_of(sealed_segments_.begin(), sealed_segments_.end(),
+		[document_id](const SealedSegmentState& state) {
+		const auto it = state.segment->ordinals.find(document_id);
+		return it != state.segment->ordinals.end() && !state.deleted[it->second];
+	});
+}
+
+std::shared_ptr<SegmentedIndex::MutableSegment> SegmentedIndex::DetachMutableSegment()
+{
+	std::shared_ptr<MutableSegment> segment = std::move(mutable_segment_);
+	mutable_segment_ = std::make_unique<MutableSegment>();
+	if (segment->ordinals.empty()) {
+		return nullptr;
+	}
+	sealing_segments_.push_back(segment);
+	return segment;
+}
+
+void SegmentedIndex::SealSegment(std::shared_ptr<MutableSegment> source)
+{
+	// built without the lock, as merges are: removals go on meanwhile and
+	// change only the deletion marks and counts, so the marks are copied
+	std::vector<bool> deleted;
+	{
+		std::shared_lock lock(mutex_);
+		deleted = source->deleted;
+	}
+	auto segment = std::make_shared<SealedSegment>();
+	// deleted documents are dropped, the rest keep their order
+	std::vector<int> new_ordinals(source->documents.size(), -1);
+	for (size_t ordinal = 0; ordinal < source->documents.size(); ++ordinal) {
+		if (!deleted[ordinal]) {
+			new_ordinals[ordinal] = static_cast<int>(segment->documents.size());
+			segment->documents.push_back(source->documents[ordinal]);
+		}
+	}
+	std::vector<TermPostingList> term_postings;
+	for (uint32_t term_id = 0; term_id < source->index.GetTermCount(); ++term_id) {
+		const PostingList& postings = source->index.GetPostings(term_id);
+		std::vector<std::pair<int, double>> sealed_postings;
+		const auto& ordinals = postings.GetDocumentIds();
+		const auto& term_freqs = postings.GetTermFreqs();
+		for (size_t i = 0; i < ordinals.size(); ++i) {
+			if (new_ordinals[ordinals[i]] >= 0) {
+				sealed_postings.emplace_back(new_ordinals[ordinals[i]], term_freqs[i]);
+			}
+		}
+		if (!sealed_postings.empty()) {
+			term_postings.emplace_back(source->index.GetTerm(term_id), std::move(sealed_postings));
+		}
+	}
+	segment->Fill(term_postings);
+
+	std::lock_guard guard(mutex_);
+	SealedSegmentState state(std::move(segment));
+	// documents removed while the segment was being sealed
+	for (size_t ordinal = 0; ordinal < deleted.size(); ++ordinal) {
+		if (source->deleted[ordinal] && !deleted[ordinal]) {
+			state.MarkDeleted(new_ordinals[ordinal]);
+		}
+	}
+	sealing_segments_.erase(std::find(sealing_segments_.begin(), sealing_segments_.end(), source));
+	sealed_segments_.push_back(std::move(state));
+	StartMergeIfNeeded();
+}
+
+void SegmentedIndex::StartMergeIfNeeded()
+{
+	if (is_merging_ || sealed_segments_.size() < options_.merge_factor) {
+		return;
+	}
+	is_merging_ = true;
+	merger_ = std::async(std::launch::async, [this]() {
+		try {
+			MergeSegments();
+		}
+		catch (...) {
+			std::lock_guard guard(mutex_);
+			is_merging_ = false;
+			throw;
+		}
+	}).share();
+}
+
+void SegmentedIndex::MergeSegments()
+{
+	while (true) {
+		// the smallest segments are merged, so every document is rewritten
+		// a logarithmic number of times
+		std::vector<std::shared_ptr<const SealedSegment>> inputs;
+		std::vector<std::vector<bool>> input_deleted;
+		{
+			std::lock_guard guard(mutex_);
+			if (sealed_segments_.size() < options_.merge_factor) {
+				is_merging_ = false;
+				return;
+			}
+			std::vector<size_t> order(sealed_segments_.size());
+			std::iota(order.begin(), order.end(), 0);
+			std::partial_sort(order.begin(), order.begin() + options_.merge_factor, order.end(),
+				[this](size_t lhs, size_t rhs) {
+				return sealed_segments_[lhs].GetLiveDocumentCount() < sealed_segments_[rhs].GetLiveDocumentCount();
+			});
+			for (size_t i = 0; i < options_.merge_factor; ++i) {
+				inputs.push_back(sealed_segments_[order[i]].segment);
+				input_deleted.push_back(sealed_segments_[order[i]].deleted);
+			}
+		}
+
+		// built without the lock: the inputs are immutable and
+		// the deletion marks were copied
+		auto merged = std::make_shared<SealedSegment>();
+		std::vector<std::vector<int>> new_ordinals(inputs.size());
+		for (size_t input = 0; input < inputs.size(); ++input) {
+			new_ordinals[input].assign(inputs[input]->documents.size(), -1);
+			for (size_t ordinal = 0; ordinal < inputs[input]->documents.size(); ++ordinal) {
+				if (!input_deleted[input][ordinal]) {
+					new_ordinals[input][ordinal] = static_cast<int>(merged->documents.size());
+					merged->documents.push_back(inputs[input]->documents[ordinal]);
+				}
+			}
+		}
+		// inputs are appended one after another, so postings stay sorted
+		std::unordered_map<std::string_view, std::vector<std::pair<int, double>>> merged_postings;
+		for (size_t input = 0; input < inputs.size(); ++input) {
+			const SealedSegment& segment = *inputs[input];
+			for (size_t term_index = 0; term_index < segment.terms.size(); ++term_index) {
+				std::vector<std::pair<int, double>>* postings = nullptr;
+				for (size_t i = segment.posting_offsets[term_index]; i < segment.posting_offsets[term_index + 1]; ++i) {
+					const int ordinal = new_ordinals[input][segment.posting_ordinals[i]];
+					if (ordinal < 0) {
+						continue;
+					}
+					if (postings == nullptr) {
+						postings = &merged_postings[segment.terms[term_index]];
+					}
+					postings->emplace_back(ordinal, segment.posting_term_freqs[i]);
+				}
+			}
+		}
+		merged->Fill(merged_postings);
+
+		std::lock_guard guard(mutex_);
+		SealedSegmentState merged_state(merged);
+		// documents removed while the merge was running
+		for (size_t input = 0; input < inputs.size(); ++input) {
+			const auto it = std::find_if(sealed_segments_.begin(), sealed_segments_.end(),
+				[&inputs, input](const SealedSegmentState& state) {
+				return state.segment == inputs[input];
+			});
+			for (size_t ordinal = 0; ordinal < it->deleted.size(); ++ordinal) {
+				if (it->deleted[ordinal] && !input_deleted[input][ordinal]) {
+					merged_state.MarkDeleted(new_ordinals[input][ordinal]);
+				}
+			}
+			sealed_segments_.erase(it);
+		}
+		sealed_segments_.push_back(std::move(merged_state));
+	}
+}
+
+std::vector<SegmentedIndex::SegmentQuery> SegmentedIndex::PrepareSegmentQueries(const Query& query) const
+{
+	std::vector<SegmentQuery> segment_queries;
+	if (document_count_ == 0) {
+		return segment_queries;
+	}
+	// document frequencies are summed over all segments first
+	std::vector<size_t> document_freqs(query.plus_words.size(), 0);
+	std::vector<std::vector<size_t>> word_indexes;
+
+	const auto add_segment = [&](const std::vector<DocumentEntry>& documents,
+		const std::vector<bool>& deleted, const auto& find_postings) {
+		SegmentQuery& segment_query = segment_queries.emplace_back();
+		auto& segment_word_indexes = word_indexes.emplace_back();
+		segment_query.documents = &documents;
+		segment_query.deleted = &deleted;
+		for (size_t index = 0; index < query.plus_words.size(); ++index) {
+			size_t live_count = 0;
+			TermPostings postings = find_postings(query.plus_words[index], live_count);
+			if (postings.size > 0) {
+				document_freqs[index] += live_count;
+				segment_query.plus_postings.push_back(postings);
+				segment_word_indexes.push_back(index);
+			}
+		}
+		for (std::string_view word : query.minus_words) {
+			size_t live_count = 0;
+			TermPostings postings = find_postings(word, live_count);
+			if (postings.size > 0) {
+				segment_query.minus_postings.push_back(postings);
+			}
+		}
+	};
+
+	const auto add_mutable_segment = [&add_segment](const MutableSegment& segment) {
+		add_segment(segment.documents, segment.deleted, [&segment](std::string_view word, size_t& live_count) {
+			const PostingList* postings = segment.index.Find(word);
+			if (postings == nullptr) {
+				return TermPostings{};
+			}
+			live_count = postings->GetDocumentFreq();
+			return TermPostings{ postings->GetDocumentIds().data(), postings->GetTermFreqs().data(), postings->size(), 0.0 };
+		});
+	};
+	add_mutable_segment(*mutable_segment_);
+	for (const auto& segment : sealing_segments_) {
+		add_mutable_segment(*segment);
+	}
+	for (const SealedSegmentState& state : sealed_segments_) {
+		add_segment(state.segment->documents, state.deleted, [&state](std::string_view word, size_t& live_count) {
+			const SealedSegment& segment = *state.segment;
+			const int term_index = segment.FindTermIndex(word);
+			if (term_index < 0) {
+				return TermPostings{};
+			}
+			const size_t offset = segment.posting_offsets[term_index];
+			const size_t postings_count = segment.posting_offsets[term_index + 1] - offset;
+			live_count = postings_count - state.deleted_term_counts[term_index];
+			return TermPostings{ segment.posting_ordinals.data() + offset,
+				segment.posting_term_freqs.data() + offset, postings_count, 0.0 };
+		});
+	}
+
+	// the same arithmetic as SearchServer
+	const double log_document_count = LogCount(document_count_);
+	for (size_t segment_index = 0; segment_index < segment_queries.size(); ++segment_index) {
+		auto& plus_postings = segment_queries[segment_index].plus_postings;
+		for (size_t i = 0; i < plus_postings.size(); ++i) {
+			const size_t document_freq = document_freqs[word_indexes[segment_index][i]];
+			plus_postings[i].inverse_document_freq = document_freq == 0 ? 0.0
+				: ComputeInverseDocumentFreq(log_document_count, LogCount(document_freq));
+		}
+	}
+	return segment_queries;
+}
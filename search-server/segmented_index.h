@@ -0,0 +1,285 @@
+#pragma once
+#include "document.h"
+#include "query_parser.h"
+#include "search_server.h"
+#include "stop_word_filter.h"
+#include "string_processing.h"
+
+#include <algorithm>
+#include <execution>
+#include <future>
+#include <memory>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+struct SegmentedIndexOptions {
+	// the mutable segment is sealed when it holds this many documents
+	size_t max_mutable_document_count = 4096;
+	// the background merger combines this many sealed segments at once
+	size_t merge_factor = 4;
+};
+
+// Log-structured variant of the search index. New documents go into a small
+// mutable segment; once it is full the writer which filled it swaps it out
+// and seals it into an immutable segment of flat posting arrays outside the
+// lock, and a background thread merges the smallest sealed segments into
+// bigger ones. A query is scored segment by segment with the document
+// frequencies of the whole index, so relevance is the same as in
+// SearchServer, and the per-segment top documents are merged.
+// All methods may be called concurrently. Sealed segments are never changed
+// or copied by readers; removal marks documents deleted and the next merge
+// drops them.
+class SegmentedIndex {
+public:
+	template <typename StringContainer>
+	explicit SegmentedIndex(const StringContainer& stop_words,
+		const SegmentedIndexOptions& options = {})
+		: SegmentedIndex(options, MakeUniqueNonEmptyStrings(stop_words))
+	{
+	}
+
+	explicit SegmentedIndex(const std::string& stop_words_text,
+		const SegmentedIndexOptions& options = {});
+
+	SegmentedIndex(const SegmentedIndex&) = delete;
+	SegmentedIndex& operator=(const SegmentedIndex&) = delete;
+
+	// waits for the background merge
+	~SegmentedIndex();
+
+	void AddDocument(int document_id, std::string_view document,
+		DocumentStatus status, const std::vector<int>& ratings);
+
+	void RemoveDocument(int document_id);
+
+	template <typename DocumentPredicate>
+	std::vector<Document> FindTopDocuments(std::string_view raw_query,
+		DocumentPredicate document_predicate,
+		size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const
+	{
+		return FindTopDocumentsImpl(std::execution::seq, raw_query, document_predicate, max_result_count);
+	}
+
+	template <typename DocumentPredicate>
+	std::vector<Document> FindTopDocuments(
+		const std::execution::sequenced_policy& policy, std::string_view raw_query,
+		DocumentPredicate document_predicate,
+		size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const
+	{
+		return FindTopDocumentsImpl(policy, raw_query, document_predicate, max_result_count);
+	}
+
+	// the parallel version scores segments concurrently
+	template <typename DocumentPredicate>
+	std::vector<Document> FindTopDocuments(
+		const std::execution::parallel_policy& policy, std::string_view raw_query,
+		DocumentPredicate document_predicate,
+		size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const
+	{
+		return FindTopDocumentsImpl(policy, raw_query, document_predicate, max_result_count);
+	}
+
+	std::vector<Document> FindTopDocuments(std::string_view raw_query,
+		DocumentStatus status = DocumentStatus::ACTUAL,
+		size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const;
+
+	std::vector<Document> FindTopDocuments(
+		const std::execution::sequenced_policy& policy, std::string_view raw_query,
+		DocumentStatus status = DocumentStatus::ACTUAL,
+		size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const;
+
+	std::vector<Document> FindTopDocuments(
+		const std::execution::parallel_policy& policy, std::string_view raw_query,
+		DocumentStatus status = DocumentStatus::ACTUAL,
+		size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const;
+
+	std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(
+		std::string_view raw_query, int document_id) const;
+
+	int GetDocumentCount() const;
+
+	size_t GetSealedSegmentCount() const;
+
+	// seals the mutable segment without waiting for it to fill up
+	void Seal();
+
+	// waits until no merge is running, rethrows an error of the merge
+	void WaitForMerges();
+
+private:
+	struct DocumentEntry {
+		int id = 0;
+		int rating = 0;
+		DocumentStatus status = DocumentStatus::ACTUAL;
+	};
+
+	struct TermPostings {
+		const int* ordinals = nullptr;
+		const double* term_freqs = nullptr;
+		size_t size = 0;
+		double inverse_document_freq = 0.0;
+	};
+
+	// everything needed to score a query in one segment,
+	// valid while the shared lock is held
+	struct SegmentQuery {
+		const std::vector<DocumentEntry>* documents = nullptr;
+		const std::vector<bool>* deleted = nullptr;
+		std::vector<TermPostings> plus_postings;
+		std::vector<TermPostings> minus_postings;
+	};
+
+	struct SealedSegment;
+	struct SealedSegmentState;
+	struct MutableSegment;
+
+	const std::set<std::string, std::less<>> stop_words_;
+	const StopWordFilter stop_word_filter_;
+	const SegmentedIndexOptions options_;
+
+	// guards everything below; sealed segment contents are immutable and are
+	// read without copying, the lock protects only the segment lists and
+	// deletion marks
+	mutable std::shared_mutex mutex_;
+	std::unique_ptr<MutableSegment> mutable_segment_;
+	// full mutable segments being sealed: they are searched and removed from
+	// as the mutable one, and the sealer reads only their documents and
+	// postings, which no longer change
+	std::vector<std::shared_ptr<MutableSegment>> sealing_segments_;
+	std::vector<SealedSegmentState> sealed_segments_;
+	int document_count_ = 0;
+	bool is_merging_ = false;
+	std::shared_future<void> merger_;
+
+	// segment types are complete only in the .cpp file, so the members
+	// are constructed there
+	SegmentedIndex(const SegmentedIndexOptions& options,
+		std::set<std::string, std::less<>> stop_words);
+
+	bool IsStopWord(std::string_view word) const;
+
+	// the lock must be held exclusively
+	bool ContainsDocument(int document_id) const;
+
+	// the lock must be held exclusively; moves the mutable segment to
+	// sealing_segments_ and returns it, or returns nullptr if it has no
+	// documents left
+	std::shared_ptr<MutableSegment> DetachMutableSegment();
+
+	// builds the sealed form of a detached segment without the lock,
+	// then replaces the segment by it
+	void SealSegment(std::shared_ptr<MutableSegment> source);
+
+	void StartMergeIfNeeded();
+
+	void MergeSegments();
+
+	// the lock must be held
+	std::vector<SegmentQuery> PrepareSegmentQueries(const Query& query) const;
+
+	template <typename ExecutionPolicy, typename DocumentPredicate>
+	std::vector<Document> FindTopDocumentsImpl(ExecutionPolicy&& policy,
+		std::string_view raw_query, DocumentPredicate document_predicate,
+		size_t max_result_count) const;
+
+	template <typename DocumentPredicate>
+	static std::vector<Document> ScoreSegment(const SegmentQuery& query,
+		DocumentPredicate& document_predicate);
+};
+
+// implementation templates
+template <typename ExecutionPolicy, typename DocumentPredicate>
+std::vector<Document> SegmentedIndex::FindTopDocumentsImpl(ExecutionPolicy&& policy,
+	std::string_view raw_query, DocumentPredicate document_predicate,
+	size_t max_result_count) const
+{
+	const auto query = ParseQuery(raw_query, [this](std::string_view word) {
+		return IsStopWord(word);
+	});
+
+	std::shared_lock lock(mutex_);
+	const auto segment_queries = PrepareSegmentQueries(query);
+	std::vector<std::vector<Document>> segment_documents(segment_queries.size());
+	std::transform(policy, segment_queries.begin(), segment_queries.end(), segment_documents.begin(),
+		[&document_predicate, max_result_count](const SegmentQuery& segment_query) {
+		auto documents = ScoreSegment(segment_query, document_predicate);
+		SearchServer::SelectTopDocuments(std::execution::seq, documents, max_result_count);
+		return documents;
+	});
+	lock.unlock();
+
+	std::vector<Document> matched_documents;
+	for (const auto& documents : segment_documents) {
+		matched_documents.insert(matched_documents.end(), documents.begin(), documents.end());
+	}
+	SearchServer::SelectTopDocuments(std::execution::seq, matched_documents, max_result_count);
+	return matched_documents;
+}
+
+template <typename DocumentPredicate>
+std::vector<Document> SegmentedIndex::ScoreSegment(const SegmentQuery& query,
+	DocumentPredicate& document_predicate)
+{
+	using ScoreScratch = SearchServer::ScoreScratch;
+	const auto& documents = *query.documents;
+	const auto& deleted = *query.deleted;
+	// the per-thread arrays of SearchServer: a query pays for the postings
+	// it reads, not for the size of the segment
+	ScoreScratch& thread_scratch = SearchServer::GetThreadScoreScratch();
+	ScoreScratch own_scratch;
+	// the predicate may run another search on the same thread
+	ScoreScratch& scratch = thread_scratch.is_used ? own_scratch : thread_scratch;
+	scratch.is_used = true;
+	if (scratch.state.size() < documents.size()) {
+		scratch.relevance.resize(documents.size(), 0.0);
+		scratch.state.resize(documents.size(), ScoreScratch::UNSEEN);
+	}
+	auto& relevance = scratch.relevance;
+	auto& state = scratch.state;
+	auto& touched = scratch.touched;
+
+	std::vector<Document> matched_documents;
+	try {
+		for (const TermPostings& postings : query.minus_postings) {
+			for (size_t i = 0; i < postings.size; ++i) {
+				const int ordinal = postings.ordinals[i];
+				if (state[ordinal] == ScoreScratch::UNSEEN) {
+					state[ordinal] = ScoreScratch::REJECTED;
+					touched.push_back(ordinal);
+				}
+			}
+		}
+
+		for (const TermPostings& postings : query.plus_postings) {
+			for (size_t i = 0; i < postings.size; ++i) {
+				const int ordinal = postings.ordinals[i];
+				if (state[ordinal] == ScoreScratch::UNSEEN) {
+					const DocumentEntry& document = documents[ordinal];
+					state[ordinal] = !deleted[ordinal]
+						&& document_predicate(document.id, document.status, document.rating)
+						? ScoreScratch::ACCEPTED : ScoreScratch::REJECTED;
+					touched.push_back(ordinal);
+				}
+				if (state[ordinal] == ScoreScratch::ACCEPTED) {
+					relevance[ordinal] += postings.term_freqs[i] * postings.inverse_document_freq;
+				}
+			}
+		}
+
+		for (const int ordinal : touched) {
+			if (state[ordinal] == ScoreScratch::ACCEPTED) {
+				matched_documents.push_back({ documents[ordinal].id, relevance[ordinal], documents[ordinal].rating });
+			}
+		}
+	}
+	catch (...) {
+		scratch.Reset();
+		throw;
+	}
+	scratch.Reset();
+	return matched_documents;
+}
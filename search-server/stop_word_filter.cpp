@@ -0,0 +1,35 @@
+#include "stop_word_filter.h"
+
+StopWordFilter::StopWordFilter(const std::set<std::string, std::less<>>& stop_words)
+	: words_(stop_words.begin(), stop_words.end())
+{
+	size_t slot_count = 1;
+	while (slot_count < words_.size() * 2) {
+		slot_count *= 2;
+	}
+	slots_.assign(slot_count, EMPTY_SLOT);
+	slot_mask_ = slot_count - 1;
+	for (uint32_t index = 0; index < words_.size(); ++index) {
+		const std::string_view word = words_[index];
+		if (word.empty()) {
+			continue;
+		}
+		const uint32_t signature = GetSignature(word);
+		signatures_[signature / 64] |= uint64_t{ 1 } << (signature % 64);
+		size_t slot = std::hash<std::string_view>{}(word) & slot_mask_;
+		while (slots_[slot] != EMPTY_SLOT) {
+			slot = (slot + 1) & slot_mask_;
+		}
+		slots_[slot] = index;
+	}
+}
+
+size_t StopWordFilter::size() const
+{
+	return words_.size();
+}
+
+size_t StopWordFilter::GetByteSize() const
+{
+	return words_.capacity() * sizeof(std::string_view) + slots_.capacity() * sizeof(uint32_t);
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Set of stop words built once and checked for every token. A word is first
+// tested against a 4096-bit mask of (length, first two chars, last char)
+// signatures of the stop words; a few hundred stop words set about a tenth
+// of the bits, so most ordinary words are rejected without hashing them.
+// The rest are looked up in an open addressing table at most half full.
+// The filter refers to the words of the given set, which must outlive it
+class StopWordFilter {
+public:
+	StopWordFilter() = default;
+
+	explicit StopWordFilter(const std::set<std::string, std::less<>>& stop_words);
+
+	// inline: runs for every token of every document and query
+	bool Contains(std::string_view word) const
+	{
+		if (word.empty()) {
+			return false;
+		}
+		const uint32_t signature = GetSignature(word);
+		if ((signatures_[signature / 64] >> (signature % 64) & 1) == 0) {
+			return false;
+		}
+		for (size_t slot = std::hash<std::string_view>{}(word) & slot_mask_;
+			slots_[slot] != EMPTY_SLOT; slot = (slot + 1) & slot_mask_) {
+			if (words_[slots_[slot]] == word) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	size_t size() const;
+
+	size_t GetByteSize() const;
+
+private:
+	static constexpr uint32_t EMPTY_SLOT = UINT32_MAX;
+	static constexpr int SIGNATURE_BITS = 12;
+
+	std::vector<std::string_view> words_;
+	// indexes into words_, the size is a power of two
+	std::vector<uint32_t> slots_;
+	size_t slot_mask_ = 0;
+	std::array<uint64_t, (1 << SIGNATURE_BITS) / 64> signatures_{};
+
+	static uint32_t GetSignature(std::string_view word)
+	{
+		const uint32_t key = static_cast<uint32_t>(word.size()) << 24
+			^ static_cast<uint32_t>(static_cast<unsigned char>(word.front())) << 16
+			^ static_cast<uint32_t>(static_cast<unsigned char>(word[word.size() > 1 ? 1 : 0])) << 8
+			^ static_cast<unsigned char>(word.back());
+		return (key * 0x9E3779B1u) >> (32 - SIGNATURE_BITS);
+	}
+};
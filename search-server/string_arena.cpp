@@ -0,0 +1,63 @@
+#include "string_arena.h"
+
+#include <cstring>
+
+StringArena::StringArena(std::pmr::memory_resource* resource)
+	: resource_(resource)
+	, chunks_(resource)
+{
+}
+
+StringArena::StringArena(StringArena&& other) noexcept
+	: resource_(other.resource_)
+	, chunks_(std::move(other.chunks_))
+	, free_begin_(std::exchange(other.free_begin_, nullptr))
+	, free_size_(std::exchange(other.free_size_, 0))
+	, byte_size_(std::exchange(other.byte_size_, 0))
+{
+	other.chunks_.clear();
+}
+
+StringArena::~StringArena()
+{
+	for (const auto& [chunk, size] : chunks_) {
+		resource_->deallocate(chunk, size, 1);
+	}
+}
+
+std::string_view StringArena::Append(std::string_view text)
+{
+	if (text.empty()) {
+		return {};
+	}
+	if (text.size() > free_size_) {
+		// a long string gets a chunk of its own and the current chunk
+		// is still filled by the following short ones
+		if (text.size() > CHUNK_SIZE / 4) {
+			char* chunk = AllocateChunk(text.size());
+			std::memcpy(chunk, text.data(), text.size());
+			return { chunk, text.size() };
+		}
+		free_begin_ = AllocateChunk(CHUNK_SIZE);
+		free_size_ = CHUNK_SIZE;
+	}
+	char* result = free_begin_;
+	std::memcpy(result, text.data(), text.size());
+	free_begin_ += text.size();
+	free_size_ -= text.size();
+	return { result, text.size() };
+}
+
+size_t StringArena::GetByteSize() const
+{
+	return byte_size_;
+}
+
+char* StringArena::AllocateChunk(size_t size)
+{
+	chunks_.reserve(chunks_.size() + 1);
+	char* chunk = static_cast<char*>(resource_->allocate(size, 1));
+	chunks_.emplace_back(chunk, size);
+	byte_size_ += size;
+	return chunk;
+}
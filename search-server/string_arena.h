@@ -0,0 +1,41 @@
+#pragma once
+#include <memory_resource>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Append-only storage of strings. Strings are copied one after another into
+// big chunks, so storing a string is usually a bump of an offset instead of
+// an allocation, and the returned views stay valid for the arena lifetime.
+// Nothing is freed before the arena is destroyed
+class StringArena {
+public:
+	explicit StringArena(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+	StringArena(const StringArena&) = delete;
+	StringArena& operator=(const StringArena&) = delete;
+
+	// chunks do not move, so views survive moving the arena
+	StringArena(StringArena&& other) noexcept;
+	StringArena& operator=(StringArena&&) = delete;
+
+	~StringArena();
+
+	std::string_view Append(std::string_view text);
+
+	// bytes of all chunks, used or not
+	size_t GetByteSize() const;
+
+private:
+	static constexpr size_t CHUNK_SIZE = 64 * 1024;
+
+	std::pmr::memory_resource* resource_;
+	// chunk addresses and sizes
+	std::pmr::vector<std::pair<char*, size_t>> chunks_;
+	// free space of the last regular chunk
+	char* free_begin_ = nullptr;
+	size_t free_size_ = 0;
+	size_t byte_size_ = 0;
+
+	char* AllocateChunk(size_t size);
+};
@@ -1,22 +1,60 @@
-#include "string_processing.h"
-
-std::vector<std::string> SplitIntoWords(const std::string& text) {
-	std::vector<std::string> words;
-	std::string word;
-	for (const char c : text) {
-		if (c == ' ') {
-			if (!word.empty()) {
-				words.push_back(word);
-				word.clear();
-			}
-		}
-		else {
-			word += c;
-		}
-	}
-	if (!word.empty()) {
-		words.push_back(word);
-	}
-
-	return words;
+#include "string_processing.h"
+#include "byte_masks.h"
+
+#include <algorithm>
+
+std::vector<std::string_view> SplitIntoWords(std::string_view text) {
+	std::vector<std::string_view> words;
+	const ByteMaskFunction space_mask = GetByteMaskKernels().space_mask;
+
+	// word boundaries are the positions where "is not a space" changes its value,
+	// whole blocks are classified by the vector kernel and only the tail byte by byte
+	bool in_word = false;
+	size_t word_begin = 0;
+	size_t block_begin = 0;
+	for (; block_begin + BYTE_MASK_BLOCK_SIZE <= text.size(); block_begin += BYTE_MASK_BLOCK_SIZE) {
+		const uint64_t word_mask = ~space_mask(text.data() + block_begin);
+		uint64_t boundaries = word_mask ^ ((word_mask << 1) | (in_word ? 1 : 0));
+		while (boundaries != 0) {
+			const size_t pos = block_begin + CountTrailingZeros(boundaries);
+			if (in_word) {
+				words.push_back(text.substr(word_begin, pos - word_begin));
+			}
+			else {
+				word_begin = pos;
+			}
+			in_word = !in_word;
+			boundaries &= boundaries - 1;
+		}
+	}
+	for (size_t pos = block_begin; pos < text.size(); ++pos) {
+		if ((text[pos] != ' ') == in_word) {
+			continue;
+		}
+		if (in_word) {
+			words.push_back(text.substr(word_begin, pos - word_begin));
+		}
+		else {
+			word_begin = pos;
+		}
+		in_word = !in_word;
+	}
+	if (in_word) {
+		words.push_back(text.substr(word_begin));
+	}
+
+	return words;
+}
+
+bool ContainsControlChars(std::string_view text) {
+	const ByteMaskFunction control_mask = GetByteMaskKernels().control_mask;
+	size_t pos = 0;
+	for (; pos + BYTE_MASK_BLOCK_SIZE <= text.size(); pos += BYTE_MASK_BLOCK_SIZE) {
+		if (control_mask(text.data() + pos) != 0) {
+			return true;
+		}
+	}
+	return std::any_of(text.begin() + pos, text.end(), [](char c) {
+		return static_cast<unsigned char>(c) < ' ';
+	});
 }
\ No newline at end of file
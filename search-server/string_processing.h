@@ -1,17 +1,22 @@
-#pragma once
-#include "read_input_functions.h"
-#include <vector>
-#include <set>
-
-std::vector<std::string> SplitIntoWords(const std::string&);
-
-template <typename StringContainer>
-std::set<std::string> MakeUniqueNonEmptyStrings(const StringContainer& strings) {
-	std::set<std::string> non_empty_strings;
-	for (const std::string& str : strings) {
-		if (!str.empty()) {
-			non_empty_strings.insert(str);
-		}
-	}
-	return non_empty_strings;
+#pragma once
+#include "read_input_functions.h"
+#include <vector>
+#include <set>
+#include <string_view>
+
+// Words are returned as views into text, so text must outlive the result
+std::vector<std::string_view> SplitIntoWords(std::string_view text);
+
+// Checks for bytes from 0 to 31, which are not allowed in words
+bool ContainsControlChars(std::string_view text);
+
+template <typename StringContainer>
+std::set<std::string, std::less<>> MakeUniqueNonEmptyStrings(const StringContainer& strings) {
+	std::set<std::string, std::less<>> non_empty_strings;
+	for (std::string_view str : strings) {
+		if (!str.empty()) {
+			non_empty_strings.emplace(str);
+		}
+	}
+	return non_empty_strings;
 }
\ No newline at end of file
@@ -0,0 +1,44 @@
+#include "term_pool.h"
+#include "memory_stats.h"
+
+TermPool::TermPool(std::pmr::memory_resource* resource)
+	: chars_(resource)
+	, terms_(resource)
+	, term_ids_(resource)
+{
+}
+
+uint32_t TermPool::Intern(std::string_view word)
+{
+	const auto it = term_ids_.find(word);
+	if (it != term_ids_.end()) {
+		return it->second;
+	}
+	const uint32_t term_id = static_cast<uint32_t>(terms_.size());
+	const std::string_view term = chars_.Append(word);
+	terms_.push_back(term);
+	term_ids_.emplace(term, term_id);
+	return term_id;
+}
+
+uint32_t TermPool::Find(std::string_view word) const
+{
+	const auto it = term_ids_.find(word);
+	return it == term_ids_.end() ? NO_TERM : it->second;
+}
+
+std::string_view TermPool::GetTerm(uint32_t term_id) const
+{
+	return terms_[term_id];
+}
+
+size_t TermPool::size() const
+{
+	return terms_.size();
+}
+
+size_t TermPool::GetByteSize() const
+{
+	return chars_.GetByteSize() + terms_.capacity() * sizeof(std::string_view)
+		+ EstimateHashBytes(term_ids_);
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include "string_arena.h"
+
+#include <cstdint>
+#include <memory_resource>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Every distinct term is stored once in an arena and numbered by a dense id
+// in the order of first appearance. Ids and views stay valid for the pool
+// lifetime, independently of the documents which introduced the terms
+class TermPool {
+public:
+	static constexpr uint32_t NO_TERM = UINT32_MAX;
+
+	explicit TermPool(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+	// id of the term, the term is added if it is new
+	uint32_t Intern(std::string_view word);
+
+	// id of the term or NO_TERM if the term is unknown
+	uint32_t Find(std::string_view word) const;
+
+	std::string_view GetTerm(uint32_t term_id) const;
+
+	size_t size() const;
+
+	// the arena, the term table and an estimate of the hash table
+	size_t GetByteSize() const;
+
+private:
+	StringArena chars_;
+	std::pmr::vector<std::string_view> terms_;
+	std::pmr::unordered_map<std::string_view, uint32_t> term_ids_;
+};
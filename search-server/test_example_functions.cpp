@@ -1,59 +1,970 @@
-#include "test_example_functions.h"
-
-void PrintDocument(const Document& document) {
-
-	std::cout << "{ "s
-		<< "document_id = "s << document.id << ", "s
-		<< "relevance = "s << document.relevance << ", "s
-		<< "rating = "s << document.rating << " }"s << std::endl;
-}
-
-void PrintMatchDocumentResult(int document_id, const std::vector<std::string>& words, DocumentStatus status) {
-
-	std::cout << "{ "s
-		<< "document_id = "s << document_id << ", "s
-		<< "status = "s << static_cast<int>(status) << ", "s
-		<< "words ="s;
-	for (const std::string& word : words) {
-		std::cout << ' ' << word;
-	}
-	std::cout << "}"s << std::endl;
-}
-
-void AddDocument(SearchServer& search_server, int document_id, const std::string& document, DocumentStatus status, const std::vector<int>& ratings) {
-
-	try {
-		search_server.AddDocument(document_id, document, status, ratings);
-	}
-	catch (const std::invalid_argument& e) {
-		std::cout << "   "s << document_id << ": "s << e.what() << std::endl;
-	}
-}
-
-void FindTopDocuments(const SearchServer& search_server, const std::string& raw_query) {
-
-	std::cout << "   : "s << raw_query << std::endl;
-	try {
-		for (const Document& document : search_server.FindTopDocuments(raw_query)) {
-			PrintDocument(document);
-		}
-	}
-	catch (const std::invalid_argument& e) {
-		std::cout << " : "s << e.what() << std::endl;
-	}
-}
-
-void MatchDocuments(const SearchServer& search_server, const std::string& query) {
-
-	try {
-		std::cout << "   : "s << query << std::endl;
-				
-		for (const int document_id : search_server) {
-			const auto[words, status] = search_server.MatchDocument(query, document_id);
-			PrintMatchDocumentResult(document_id, words, status);
-		}
-	}
-	catch (const std::invalid_argument& e) {
-		std::cout << "     "s << query << ": "s << e.what() << std::endl;
-	}
-}
\ No newline at end of file
+#include "test_example_functions.h"
+#include "concurrent_map.h"
+#include "concurrent_search_server.h"
+#include "counting_memory_resource.h"
+#include "index_snapshot.h"
+#include "process_queries.h"
+#include "remove_duplicates.h"
+#include "segmented_index.h"
+#include "string_processing.h"
+#include "stop_word_filter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <map>
+#include <memory_resource>
+#include <optional>
+#include <random>
+#include <set>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "for_tests.h"
+
+void PrintDocument(const Document& document) {
+
+	std::cout << "{ "s
+		<< "document_id = "s << document.id << ", "s
+		<< "relevance = "s << document.relevance << ", "s
+		<< "rating = "s << document.rating << " }"s << std::endl;
+}
+
+void PrintMatchDocumentResult(int document_id, const std::vector<std::string_view>& words, DocumentStatus status) {
+
+	std::cout << "{ "s
+		<< "document_id = "s << document_id << ", "s
+		<< "status = "s << static_cast<int>(status) << ", "s
+		<< "words ="s;
+	for (std::string_view word : words) {
+		std::cout << ' ' << word;
+	}
+	std::cout << "}"s << std::endl;
+}
+
+void AddDocument(SearchServer& search_server, int document_id, const std::string& document, DocumentStatus status, const std::vector<int>& ratings) {
+
+	try {
+		search_server.AddDocument(document_id, document, status, ratings);
+	}
+	catch (const std::invalid_argument& e) {
+		std::cout << "   "s << document_id << ": "s << e.what() << std::endl;
+	}
+}
+
+void FindTopDocuments(const SearchServer& search_server, const std::string& raw_query) {
+
+	std::cout << "   : "s << raw_query << std::endl;
+	try {
+		for (const Document& document : search_server.FindTopDocuments(raw_query)) {
+			PrintDocument(document);
+		}
+	}
+	catch (const std::invalid_argument& e) {
+		std::cout << " : "s << e.what() << std::endl;
+	}
+}
+
+void MatchDocuments(const SearchServer& search_server, const std::string& query) {
+
+	try {
+		std::cout << "   : "s << query << std::endl;
+				
+		for (const int document_id : search_server) {
+			const auto[words, status] = search_server.MatchDocument(query, document_id);
+			PrintMatchDocumentResult(document_id, words, status);
+		}
+	}
+	catch (const std::invalid_argument& e) {
+		std::cout << "     "s << query << ": "s << e.what() << std::endl;
+	}
+}
+
+// -------- Unit tests --------
+
+// texts of a random corpus over a small vocabulary, the low words are the most frequent
+static std::vector<std::string> MakeTestTexts(int document_count, unsigned seed)
+{
+	std::mt19937 generator(seed);
+	std::vector<std::string> texts(document_count);
+	for (std::string& text : texts) {
+		const int word_count = static_cast<int>(generator() % 12) + 1;
+		for (int i = 0; i < word_count; ++i) {
+			const unsigned word = (generator() % 60) * (generator() % 60) / 60;
+			text += (i > 0 ? " w"s : "w"s) + std::to_string(word);
+		}
+	}
+	return texts;
+}
+
+// ratings are the ids, so the order of the results is unique
+static void AddTestDocuments(SearchServer& search_server, const std::vector<std::string>& texts)
+{
+	for (int id = 0; id < static_cast<int>(texts.size()); ++id) {
+		search_server.AddDocument(id, texts[id], DocumentStatus::ACTUAL, { id });
+	}
+}
+
+static std::vector<std::string> MakeTestQueries()
+{
+	std::vector<std::string> queries;
+	for (int i = 0; i < 40; ++i) {
+		queries.push_back("w"s + std::to_string(i % 7) + " w"s + std::to_string(i + 3)
+			+ (i % 3 == 0 ? " -w"s + std::to_string(i % 11 + 1) : ""s));
+	}
+	return queries;
+}
+
+static void AssertEqualDocuments(const std::vector<Document>& lhs, const std::vector<Document>& rhs,
+	const std::string& hint)
+{
+	ASSERT_EQUAL_HINT(lhs.size(), rhs.size(), hint);
+	for (size_t i = 0; i < lhs.size(); ++i) {
+		ASSERT_EQUAL_HINT(lhs[i].id, rhs[i].id, hint);
+		ASSERT_HINT(std::abs(lhs[i].relevance - rhs[i].relevance) < EPSILON, hint);
+		ASSERT_EQUAL_HINT(lhs[i].rating, rhs[i].rating, hint);
+	}
+}
+
+void TestIndexSnapshot()
+{
+	const std::string path = "index_snapshot_test.bin"s;
+	SearchServer search_server("w0"s);
+	AddTestDocuments(search_server, MakeTestTexts(2000, 10));
+	search_server.RemoveDocument(5);
+	IndexSnapshot::Save(search_server, path);
+	for (const IndexSnapshot::Check check : { IndexSnapshot::Check::FULL, IndexSnapshot::Check::LAYOUT }) {
+		const IndexSnapshot snapshot(path, check);
+		ASSERT_EQUAL(snapshot.GetDocumentCount(), search_server.GetDocumentCount());
+		for (const std::string& query : MakeTestQueries()) {
+			const auto documents = snapshot.FindTopDocuments(query, DocumentStatus::ACTUAL, 20);
+			const auto expected = search_server.FindTopDocuments(query, DocumentStatus::ACTUAL, 20);
+			AssertEqualDocuments(documents, expected, query);
+			// idf is computed by the same arithmetic
+			for (size_t i = 0; i < documents.size(); ++i) {
+				ASSERT_HINT(documents[i].relevance == expected[i].relevance, query);
+			}
+		}
+		// the matched words view the query, which must outlive them
+		const std::string query = "w1 w2 w3 w4 w5"s;
+		auto [words, status] = snapshot.MatchDocument(query, 7);
+		auto expected_words = std::get<0>(search_server.MatchDocument(query, 7));
+		std::sort(words.begin(), words.end());
+		std::sort(expected_words.begin(), expected_words.end());
+		ASSERT(words == expected_words);
+		ASSERT(status == DocumentStatus::ACTUAL);
+	}
+
+	// overwrites count values of a section whose offset is the header field
+	// at field_offset, then checks that the file is rejected
+	const auto assert_corrupt_rejected = [&](uint64_t field_offset, uint32_t value, uint64_t count) {
+		IndexSnapshot::Save(search_server, path);
+		{
+			std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+			uint64_t section_offset = 0;
+			file.seekg(static_cast<std::streamoff>(field_offset));
+			file.read(reinterpret_cast<char*>(&section_offset), sizeof(section_offset));
+			file.seekp(static_cast<std::streamoff>(section_offset));
+			for (uint64_t i = 0; i < count; ++i) {
+				file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+			}
+		}
+		bool is_rejected = false;
+		try {
+			IndexSnapshot snapshot(path);
+		}
+		catch (const std::runtime_error&) {
+			is_rejected = true;
+		}
+		ASSERT(is_rejected);
+	};
+	// header fields: 16 bytes of magic and version, then 8-byte values
+	const uint64_t hash_slot_count_field = 16 + 4 * 8;
+	const uint64_t hash_slots_field = 16 + 7 * 8;
+	const uint64_t posting_ordinals_field = 16 + 8 * 8;
+	// an ordinal out of the document table
+	assert_corrupt_rejected(posting_ordinals_field, 1'000'000, 1);
+	// a hash table without empty slots
+	uint64_t hash_slot_count = 0;
+	{
+		std::ifstream file(path, std::ios::binary);
+		file.seekg(static_cast<std::streamoff>(hash_slot_count_field));
+		file.read(reinterpret_cast<char*>(&hash_slot_count), sizeof(hash_slot_count));
+	}
+	assert_corrupt_rejected(hash_slots_field, 1, hash_slot_count);
+	std::remove(path.c_str());
+}
+
+static bool test_accept_odd_ids = false;
+
+void TestQueryCache()
+{
+	SearchServer search_server("w0"s);
+	AddTestDocuments(search_server, MakeTestTexts(500, 12));
+	search_server.SetQueryCacheCapacity(10);
+	const auto by_flag = [](int document_id, DocumentStatus, int) {
+		return (document_id % 2 == 1) == test_accept_odd_ids;
+	};
+
+	// an unmarked predicate reading a global is evaluated on every search
+	const auto even_documents = search_server.FindTopDocuments("w1 w2"s, by_flag);
+	ASSERT(!even_documents.empty());
+	test_accept_odd_ids = true;
+	for (const Document& document : search_server.FindTopDocuments("w1 w2"s, by_flag)) {
+		ASSERT_EQUAL(document.id % 2, 1);
+	}
+	test_accept_odd_ids = false;
+
+	// a marked one is answered from the cache until the documents change
+	const auto cacheable = MakeCacheablePredicate([](int document_id, DocumentStatus, int) {
+		return document_id % 3 == 0;
+	});
+	const auto expected = search_server.FindTopDocuments("w1 w2 -w3"s, cacheable);
+	AssertEqualDocuments(search_server.FindTopDocuments("w1 w2 -w3"s, cacheable), expected, "cached"s);
+	AssertEqualDocuments(search_server.FindTopDocuments(std::execution::par, "w1 w2 -w3"s, cacheable), expected, "par"s);
+	search_server.RemoveDocument(expected.front().id);
+	const auto after_removal = search_server.FindTopDocuments("w1 w2 -w3"s, cacheable);
+	ASSERT(after_removal.empty() || after_removal.front().id != expected.front().id);
+}
+
+void TestDeferredRemoval()
+{
+	const auto texts = MakeTestTexts(3000, 14);
+	// the compaction thread never touches the resource of the server
+	std::pmr::unsynchronized_pool_resource resource;
+	SearchServer immediate("w0"s);
+	SearchServer deferred("w0"s, &resource);
+	AddTestDocuments(immediate, texts);
+	AddTestDocuments(deferred, texts);
+	deferred.SetRemovalMode(RemovalMode::DEFERRED);
+	const auto queries = MakeTestQueries();
+	const auto assert_same_results = [&](const SearchServer& search_server, const std::string& stage) {
+		ASSERT_EQUAL_HINT(search_server.GetDocumentCount(), immediate.GetDocumentCount(), stage);
+		for (const std::string& query : queries) {
+			AssertEqualDocuments(search_server.FindTopDocuments(query, DocumentStatus::ACTUAL, 10),
+				immediate.FindTopDocuments(query, DocumentStatus::ACTUAL, 10), stage + ": "s + query);
+			AssertEqualDocuments(search_server.FindTopDocuments(std::execution::par, query, DocumentStatus::ACTUAL, 10),
+				immediate.FindTopDocuments(std::execution::par, query, DocumentStatus::ACTUAL, 10), stage + ": "s + query);
+		}
+	};
+
+	std::vector<int> first_ids;
+	for (int id = 0; id < 3000; id += 7) {
+		first_ids.push_back(id);
+	}
+	immediate.RemoveDocuments(first_ids);
+	deferred.RemoveDocuments(first_ids);
+	ASSERT_EQUAL(deferred.GetDeletedDocumentCount(), first_ids.size());
+	assert_same_results(deferred, "removed"s);
+
+	const size_t forward_index_count = deferred.GetMemoryStats().forward_index.count;
+	deferred.StartCompaction();
+	ASSERT_EQUAL(deferred.GetDeletedDocumentCount(), first_ids.size());
+	// the words of the compacted documents are dropped only when the result is applied
+	ASSERT_EQUAL(deferred.GetMemoryStats().forward_index.count, forward_index_count);
+	// removals and queries go on while the compaction runs
+	for (int id = 1; id < 3000; id += 11) {
+		immediate.RemoveDocument(id);
+		deferred.RemoveDocument(id);
+	}
+	assert_same_results(deferred, "compacting"s);
+	while (!deferred.TryFinishCompaction()) {
+		std::this_thread::yield();
+	}
+	ASSERT(!deferred.IsCompactionRunning());
+	ASSERT(deferred.GetMemoryStats().forward_index.count < forward_index_count);
+	assert_same_results(deferred, "compacted"s);
+
+	// the second batch is compacted during a move
+	ASSERT(deferred.GetDeletedDocumentCount() > 0);
+	deferred.StartCompaction();
+	SearchServer moved(std::move(deferred));
+	ASSERT(!moved.IsCompactionRunning());
+	ASSERT_EQUAL(moved.GetDeletedDocumentCount(), 0u);
+	assert_same_results(moved, "moved"s);
+
+	// every posting of a removed document is reclaimed
+	ASSERT_EQUAL(moved.GetMemoryStats().postings.count, immediate.GetMemoryStats().postings.count);
+	for (const int id : immediate) {
+		ASSERT(moved.GetWordFrequencies(id) == immediate.GetWordFrequencies(id));
+	}
+}
+
+void TestRemoveDuplicates()
+{
+	for (const ForwardIndexMode mode : { ForwardIndexMode::FULL, ForwardIndexMode::COMPACT, ForwardIndexMode::NONE }) {
+		// the sequential removal does not need a thread safe resource
+		std::pmr::unsynchronized_pool_resource resource;
+		SearchServer search_server("and with"s, &resource, mode);
+		search_server.AddDocument(1, "funny pet and nasty rat"s, DocumentStatus::ACTUAL, { 7, 2, 7 });
+		search_server.AddDocument(2, "funny pet with curly hair"s, DocumentStatus::ACTUAL, { 1, 2 });
+		// the same words in another order and number
+		search_server.AddDocument(3, "rat nasty pet funny funny"s, DocumentStatus::ACTUAL, { 1, 2 });
+		// only stop words differ
+		search_server.AddDocument(4, "funny pet with nasty rat"s, DocumentStatus::ACTUAL, { 1, 2 });
+		search_server.AddDocument(5, "funny pet and not very nasty rat"s, DocumentStatus::ACTUAL, { 1, 2 });
+		search_server.AddDocument(6, "pet rat"s, DocumentStatus::ACTUAL, { 1, 2 });
+		search_server.AddDocument(7, "rat pet"s, DocumentStatus::ACTUAL, { 1, 2 });
+		ASSERT(RemoveDuplicates(search_server) == std::vector<int>({ 3, 4, 7 }));
+		ASSERT_EQUAL(search_server.GetDocumentCount(), 4);
+	}
+
+	const auto texts = MakeTestTexts(3000, 50);
+	std::pmr::synchronized_pool_resource resource;
+	SearchServer parallel("w0"s, &resource);
+	SearchServer sequential("w0"s);
+	for (int id = 0; id < 3000; ++id) {
+		// every fifth document repeats an earlier one
+		const std::string& text = texts[id % 5 == 4 ? id / 2 : id];
+		parallel.AddDocument(id, text, DocumentStatus::ACTUAL, { id });
+		sequential.AddDocument(id, text, DocumentStatus::ACTUAL, { id });
+	}
+	const auto duplicates = RemoveDuplicates(std::execution::par, parallel);
+	ASSERT(!duplicates.empty());
+	ASSERT(duplicates == RemoveDuplicates(sequential));
+	ASSERT_EQUAL(parallel.GetDocumentCount(), sequential.GetDocumentCount());
+	for (const std::string& query : MakeTestQueries()) {
+		AssertEqualDocuments(parallel.FindTopDocuments(query), sequential.FindTopDocuments(query), query);
+	}
+}
+
+void TestConcurrentSearchServer()
+{
+	ConcurrentSearchServer search_server("and"s);
+	// every write adds two documents with a word of their own,
+	// so a reader sees both of them or none
+	const int batch_count = 200;
+	std::atomic<bool> is_writing = true;
+	std::vector<std::future<void>> readers;
+	for (int reader = 0; reader < 3; ++reader) {
+		readers.push_back(std::async(std::launch::async, [&search_server, &is_writing, reader]() {
+			for (int i = 0; is_writing || i < batch_count; ++i) {
+				const auto snapshot = search_server.GetSnapshot();
+				ASSERT_EQUAL(snapshot->GetDocumentCount() % 2, 0);
+				const std::string query = "batch"s + std::to_string((i * 7 + reader) % batch_count);
+				const size_t found_count = snapshot->FindTopDocuments(query).size();
+				ASSERT(found_count == 0 || found_count == 2);
+			}
+		}));
+	}
+	for (int batch = 0; batch < batch_count; ++batch) {
+		const std::string word = "batch"s + std::to_string(batch);
+		if (batch % 2 == 0) {
+			search_server.AddDocuments({ { batch * 2, word + " cat"s, DocumentStatus::ACTUAL, { 1 } },
+				{ batch * 2 + 1, word + " dog"s, DocumentStatus::ACTUAL, { 2 } } });
+		}
+		else {
+			search_server.Modify([batch, &word](SearchServer& server) {
+				server.AddDocument(batch * 2, word + " cat"s, DocumentStatus::ACTUAL, { 1 });
+				server.AddDocument(batch * 2 + 1, word + " dog"s, DocumentStatus::ACTUAL, { 2 });
+			});
+		}
+	}
+	is_writing = false;
+	for (auto& reader : readers) {
+		reader.get();
+	}
+	ASSERT_EQUAL(search_server.GetDocumentCount(), batch_count * 2);
+
+	// a held snapshot keeps its version, the writer waits for its release
+	auto snapshot = search_server.GetSnapshot();
+	auto writer = std::async(std::launch::async, [&search_server]() {
+		search_server.RemoveDocuments({ 0, 1 });
+	});
+	while (search_server.GetDocumentCount() == batch_count * 2) {
+		std::this_thread::yield();
+	}
+	ASSERT_EQUAL(snapshot->GetDocumentCount(), batch_count * 2);
+	ASSERT_EQUAL(snapshot->FindTopDocuments("batch0"s).size(), 2u);
+	ASSERT(search_server.FindTopDocuments("batch0"s).empty());
+	snapshot.reset();
+	writer.get();
+	ASSERT(search_server.FindTopDocuments("batch0"s).empty());
+	ASSERT_EQUAL(search_server.FindTopDocuments("batch1"s).size(), 2u);
+
+	// an update failing on the second copy is published already; the second
+	// copy is rebuilt, so both copies agree on later writes
+	int update_count = 0;
+	bool is_rethrown = false;
+	try {
+		search_server.Modify([&update_count](SearchServer& server) {
+			if (++update_count == 2) {
+				throw std::runtime_error("update failed"s);
+			}
+			server.AddDocument(10'000, "failed update"s, DocumentStatus::ACTUAL, { 3, 5 });
+		});
+	}
+	catch (const std::runtime_error&) {
+		is_rethrown = true;
+	}
+	ASSERT(is_rethrown);
+	// the next two writes publish each copy in turn
+	for (const int document_id : { 10'001, 10'002 }) {
+		search_server.AddDocument(document_id, "next update"s, DocumentStatus::ACTUAL, { 1 });
+		ASSERT_EQUAL(search_server.GetDocumentCount(), batch_count * 2 - 2 + document_id - 9'999);
+		const auto documents = search_server.FindTopDocuments("failed"s);
+		ASSERT_EQUAL(documents.size(), 1u);
+		ASSERT_EQUAL(documents[0].rating, 4);
+		ASSERT_EQUAL(search_server.FindTopDocuments("next"s).size(), static_cast<size_t>(document_id - 10'000));
+		ASSERT(search_server.FindTopDocuments("batch0"s).empty());
+	}
+}
+
+void TestSegmentedIndex()
+{
+	const auto texts = MakeTestTexts(5000, 16);
+	SearchServer search_server("w0 w13"s);
+	SegmentedIndex segmented_index("w0 w13"s, SegmentedIndexOptions{ 128, 2 });
+	const auto queries = MakeTestQueries();
+	const auto assert_same_results = [&](const std::string& stage) {
+		ASSERT_EQUAL_HINT(segmented_index.GetDocumentCount(), search_server.GetDocumentCount(), stage);
+		for (const std::string& query : queries) {
+			const auto expected = search_server.FindTopDocuments(query, DocumentStatus::ACTUAL, 10);
+			AssertEqualDocuments(segmented_index.FindTopDocuments(query, DocumentStatus::ACTUAL, 10), expected, stage + ": "s + query);
+			AssertEqualDocuments(segmented_index.FindTopDocuments(std::execution::par, query, DocumentStatus::ACTUAL, 10), expected, stage + ": "s + query);
+		}
+	};
+	const auto add_documents = [&](int first_id, int last_id) {
+		for (int id = first_id; id < last_id; ++id) {
+			const DocumentStatus status = id % 10 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL;
+			search_server.AddDocument(id, texts[id], status, { id });
+			segmented_index.AddDocument(id, texts[id], status, { id });
+		}
+	};
+
+	add_documents(0, 1000);
+	assert_same_results("first documents"s);
+	segmented_index.WaitForMerges();
+	ASSERT(segmented_index.GetSealedSegmentCount() > 0);
+	assert_same_results("merged"s);
+
+	// documents of sealed segments, of merged ones and of the mutable one
+	std::vector<int> removed_ids;
+	for (int id = 0; id < 1000; id += 9) {
+		removed_ids.push_back(id);
+	}
+	removed_ids.push_back(999);
+	for (const int id : removed_ids) {
+		search_server.RemoveDocument(id);
+		segmented_index.RemoveDocument(id);
+	}
+	segmented_index.RemoveDocument(100'000);
+	assert_same_results("removed"s);
+
+	// merges drop the removed documents while queries go on
+	add_documents(1000, 3000);
+	assert_same_results("merging"s);
+	segmented_index.Seal();
+	segmented_index.WaitForMerges();
+	assert_same_results("all merged"s);
+
+	// writers seal segments outside the lock while queries and removals go on,
+	// removals hit the segments being sealed
+	std::atomic<bool> is_writing = true;
+	auto reader = std::async(std::launch::async, [&]() {
+		for (size_t i = 0; is_writing; ++i) {
+			segmented_index.FindTopDocuments(queries[i % queries.size()]);
+		}
+	});
+	std::vector<std::future<void>> writers;
+	for (int first_id = 3000; first_id < 5000; first_id += 1000) {
+		writers.push_back(std::async(std::launch::async, [&segmented_index, &texts, first_id]() {
+			for (int id = first_id; id < first_id + 1000; ++id) {
+				const DocumentStatus status = id % 10 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL;
+				segmented_index.AddDocument(id, texts[id], status, { id });
+				// a document of the same writer, added already
+				if (id % 7 == 0 && id - 100 >= first_id) {
+					segmented_index.RemoveDocument(id - 100);
+				}
+			}
+		}));
+	}
+	for (auto& writer : writers) {
+		writer.get();
+	}
+	is_writing = false;
+	reader.get();
+	for (int id = 3000; id < 5000; ++id) {
+		const DocumentStatus status = id % 10 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL;
+		search_server.AddDocument(id, texts[id], status, { id });
+		if (id % 7 == 0 && id - 100 >= id / 1000 * 1000) {
+			search_server.RemoveDocument(id - 100);
+		}
+	}
+	segmented_index.WaitForMerges();
+	assert_same_results("written concurrently"s);
+
+	// the matched words view the query, which must outlive them
+	const std::string query = "w1 w2 w3 -w4"s;
+	const auto [words, status] = segmented_index.MatchDocument(query, 1001);
+	const auto [expected_words, expected_status] = search_server.MatchDocument(query, 1001);
+	ASSERT(words == expected_words);
+	ASSERT(status == expected_status);
+
+	bool is_rejected = false;
+	try {
+		segmented_index.AddDocument(5, "w1"s, DocumentStatus::ACTUAL, { 1 });
+	}
+	catch (const std::invalid_argument&) {
+		is_rejected = true;
+	}
+	ASSERT(is_rejected);
+}
+
+void TestMaxScore()
+{
+	SearchServer search_server("w0"s);
+	AddTestDocuments(search_server, MakeTestTexts(5000, 20));
+	search_server.SetRemovalMode(RemovalMode::DEFERRED);
+	for (int id = 0; id < 5000; id += 3) {
+		search_server.RemoveDocument(id);
+	}
+	search_server.CompressPostings();
+	ASSERT(search_server.GetDeletedDocumentCount() > 0);
+
+	// the sequenced search of a multi-word query is pruned, the parallel one is not
+	std::mt19937 generator(21);
+	std::vector<std::string> queries = MakeTestQueries();
+	for (int i = 0; i < 200; ++i) {
+		std::string query;
+		const int word_count = static_cast<int>(generator() % 5) + 2;
+		for (int j = 0; j < word_count; ++j) {
+			query += (generator() % 6 == 0 ? " -w"s : " w"s) + std::to_string(generator() % 60);
+		}
+		queries.push_back(query);
+	}
+	for (const std::string& query : queries) {
+		for (const size_t max_result_count : { 1u, 5u, 50u }) {
+			AssertEqualDocuments(search_server.FindTopDocuments(query, DocumentStatus::ACTUAL, max_result_count),
+				search_server.FindTopDocuments(std::execution::par, query, DocumentStatus::ACTUAL, max_result_count),
+				query);
+		}
+		const auto predicate = [](int document_id, DocumentStatus, int) {
+			return document_id % 4 != 1;
+		};
+		AssertEqualDocuments(search_server.FindTopDocuments(query, predicate),
+			search_server.FindTopDocuments(std::execution::par, query, predicate), query);
+	}
+}
+
+void TestForwardIndexModes()
+{
+	const auto texts = MakeTestTexts(1000, 30);
+	SearchServer full("w0"s);
+	SearchServer compact("w0"s, ForwardIndexMode::COMPACT);
+	SearchServer none("w0"s, ForwardIndexMode::NONE);
+	for (SearchServer* search_server : { &full, &compact, &none }) {
+		AddTestDocuments(*search_server, texts);
+		for (int id = 0; id < 1000; id += 9) {
+			search_server->RemoveDocument(id);
+		}
+	}
+	for (const int id : full) {
+		const auto& word_freqs = full.GetWordFrequencies(id);
+		ASSERT(full.GetWordFrequenciesCopy(id) == word_freqs);
+		ASSERT(compact.GetWordFrequenciesCopy(id) == word_freqs);
+		ASSERT(none.GetWordFrequenciesCopy(id) == word_freqs);
+	}
+	// copies of different documents do not alias each other
+	ASSERT(compact.GetWordFrequenciesCopy(1) != compact.GetWordFrequenciesCopy(2));
+	ASSERT(compact.GetWordFrequenciesCopy(0).empty());
+	ASSERT(full.GetWordFrequencies(0).empty());
+	// the other modes keep the maps they hand out, so the references stay valid
+	for (SearchServer* search_server : { &compact, &none }) {
+		const auto& word_freqs = search_server->GetWordFrequencies(1);
+		ASSERT(word_freqs == full.GetWordFrequencies(1));
+		ASSERT(&search_server->GetWordFrequencies(1) == &word_freqs);
+		ASSERT(search_server->GetWordFrequencies(2) == full.GetWordFrequencies(2));
+		ASSERT(word_freqs == full.GetWordFrequencies(1));
+		ASSERT(search_server->GetWordFrequencies(0).empty());
+
+		search_server->RemoveDocument(1);
+		ASSERT(search_server->GetWordFrequencies(1).empty());
+		search_server->SetRemovalMode(RemovalMode::DEFERRED);
+		search_server->GetWordFrequencies(2);
+		search_server->RemoveDocument(2);
+		ASSERT(search_server->GetWordFrequencies(2).empty());
+
+		const auto& moved_word_freqs = search_server->GetWordFrequencies(3);
+		const SearchServer moved(std::move(*search_server));
+		ASSERT(&moved.GetWordFrequencies(3) == &moved_word_freqs);
+		ASSERT(moved_word_freqs == full.GetWordFrequencies(3));
+	}
+}
+
+void TestStopWordFilter()
+{
+	std::mt19937 generator(40);
+	const auto make_word = [&generator]() {
+		std::string word(generator() % 8 + 1, ' ');
+		for (char& c : word) {
+			c = static_cast<char>('a' + generator() % 6);
+		}
+		return word;
+	};
+	for (const int stop_word_count : { 0, 1, 20, 300, 2000 }) {
+		std::set<std::string, std::less<>> stop_words;
+		while (static_cast<int>(stop_words.size()) < stop_word_count) {
+			stop_words.insert(make_word());
+		}
+		const StopWordFilter filter(stop_words);
+		ASSERT_EQUAL(filter.size(), stop_words.size());
+		ASSERT(!filter.Contains(""s));
+		for (const std::string& stop_word : stop_words) {
+			ASSERT_HINT(filter.Contains(stop_word), stop_word);
+		}
+		for (int i = 0; i < 5000; ++i) {
+			const std::string word = make_word();
+			ASSERT_EQUAL_HINT(filter.Contains(word), stop_words.count(word) > 0, word);
+		}
+	}
+}
+
+void TestConcurrentMap()
+{
+	// increments from several threads are all counted
+	{
+		ConcurrentMap<int, int> counters(7);
+		std::vector<std::future<void>> workers;
+		for (int worker = 0; worker < 4; ++worker) {
+			workers.push_back(std::async(std::launch::async, [&counters]() {
+				for (int i = 0; i < 20000; ++i) {
+					++counters[i % 1000].ref_to_value;
+				}
+			}));
+		}
+		for (auto& worker : workers) {
+			worker.get();
+		}
+		const auto counts = counters.BuildOrdinaryMap();
+		ASSERT_EQUAL(counts.size(), 1000u);
+		for (const auto& [key, count] : counts) {
+			ASSERT_EQUAL_HINT(count, 80, std::to_string(key));
+		}
+	}
+	// string_view keys against std::map, with erasures between insertions
+	const std::vector<std::string> words = [] {
+		std::vector<std::string> words;
+		for (int i = 0; i < 3000; ++i) {
+			words.push_back("word"s + std::to_string(i * 7919 % 3001));
+		}
+		return words;
+	}();
+	ConcurrentMap<std::string_view, int> map(3);
+	std::map<std::string_view, int> expected;
+	for (int i = 0; i < static_cast<int>(words.size()); ++i) {
+		ASSERT_EQUAL(map.InsertOrAssign(words[i], i), expected.count(words[i]) == 0);
+		expected[words[i]] = i;
+		if (i % 3 == 0) {
+			const std::string_view erased = words[i / 2];
+			ASSERT_EQUAL(map.Erase(erased), expected.erase(erased));
+		}
+	}
+	ASSERT_EQUAL(map.size(), expected.size());
+	ASSERT(!map.Find(std::string_view("absent")).has_value());
+	for (const std::string& word : words) {
+		const auto it = expected.find(word);
+		ASSERT_EQUAL_HINT(map.Contains(word), it != expected.end(), word);
+		ASSERT_HINT(map.Find(word) == (it == expected.end() ? std::nullopt : std::optional(it->second)), word);
+	}
+
+	// Merge combines the values of present keys and inserts the others
+	std::vector<std::pair<std::string_view, int>> items;
+	for (int i = 0; i < 100; ++i) {
+		items.emplace_back(words[i], 1);
+		expected[words[i]] += 1;
+	}
+	map.Merge(items, [](int& value, int addition) {
+		value += addition;
+	});
+	map.ForEach([](std::string_view, int& value) {
+		value *= 2;
+	});
+	std::map<std::string_view, int> visited;
+	std::as_const(map).ForEach([&visited](std::string_view key, int value) {
+		ASSERT(visited.emplace(key, value).second);
+	});
+	ASSERT_EQUAL(visited.size(), expected.size());
+	for (const auto& [key, value] : expected) {
+		ASSERT_EQUAL_HINT(visited.at(key), value * 2, std::string(key));
+	}
+	map.Clear();
+	ASSERT_EQUAL(map.size(), 0u);
+	ASSERT(map.BuildOrdinaryMap().empty());
+}
+
+void TestProcessQueries()
+{
+	SearchServer search_server("w0"s);
+	AddTestDocuments(search_server, MakeTestTexts(2000, 50));
+	const auto queries = MakeTestQueries();
+	const auto results = ProcessQueries(search_server, queries);
+	ASSERT_EQUAL(results.size(), queries.size());
+	std::vector<Document> expected_joined;
+	for (size_t i = 0; i < queries.size(); ++i) {
+		const auto expected = search_server.FindTopDocuments(queries[i]);
+		AssertEqualDocuments(results[i], expected, queries[i]);
+		expected_joined.insert(expected_joined.end(), expected.begin(), expected.end());
+	}
+	AssertEqualDocuments(ProcessQueriesJoined(search_server, queries), expected_joined, "joined"s);
+
+	ASSERT(ProcessQueries(search_server, {}).empty());
+	ASSERT(ProcessQueriesJoined(search_server, {}).empty());
+}
+
+// byte by byte versions of SplitIntoWords and ContainsControlChars
+static std::vector<std::string_view> SplitIntoWordsScalar(std::string_view text)
+{
+	std::vector<std::string_view> words;
+	size_t pos = 0;
+	while (pos < text.size()) {
+		const size_t word_begin = text.find_first_not_of(' ', pos);
+		if (word_begin == std::string_view::npos) {
+			break;
+		}
+		const size_t word_end = std::min(text.find(' ', word_begin), text.size());
+		words.push_back(text.substr(word_begin, word_end - word_begin));
+		pos = word_end;
+	}
+	return words;
+}
+
+static bool ContainsControlCharsScalar(std::string_view text)
+{
+	for (const char c : text) {
+		if (static_cast<unsigned char>(c) < ' ') {
+			return true;
+		}
+	}
+	return false;
+}
+
+void TestByteMasks()
+{
+	// texts span several 64-byte blocks, so words and space runs cross
+	// block boundaries and the kernels carry the state between blocks
+	std::mt19937 generator(60);
+	std::vector<std::string> texts;
+	for (int i = 0; i < 2000; ++i) {
+		std::string text(generator() % 400, 'x');
+		for (char& c : text) {
+			const unsigned kind = generator() % 8;
+			c = kind < 3 ? ' ' : static_cast<char>(kind < 7 ? 'a' + generator() % 26 : 128 + generator() % 128);
+		}
+		texts.push_back(text);
+	}
+	const std::string long_word(200, 'w');
+	texts.push_back(long_word);
+	texts.push_back(std::string(150, ' '));
+	texts.push_back(std::string(60, 'a') + " "s + std::string(10, 'b') + std::string(60, ' ') + "c"s);
+	texts.push_back(std::string(63, 'a') + " "s + std::string(64, 'b'));
+	texts.push_back(std::string(64, 'a') + std::string(64, ' '));
+	for (const std::string& text : texts) {
+		ASSERT_HINT(SplitIntoWords(text) == SplitIntoWordsScalar(text), text);
+		ASSERT_HINT(!ContainsControlChars(text), text);
+	}
+
+	for (const size_t size : { 64u, 65u, 128u, 129u, 300u }) {
+		for (size_t pos = 0; pos < size; pos += (pos < 60 ? 30 : 1)) {
+			for (const char control : { '\0', '\t', '\n', '\x1F' }) {
+				std::string text(size, 'a');
+				text[pos] = control;
+				ASSERT_HINT(ContainsControlChars(text), std::to_string(size) + " "s + std::to_string(pos));
+				ASSERT(ContainsControlChars(text) == ContainsControlCharsScalar(text));
+			}
+		}
+	}
+}
+
+void TestAddDocuments()
+{
+	const auto texts = MakeTestTexts(3000, 70);
+	const auto queries = MakeTestQueries();
+	for (const ForwardIndexMode mode : { ForwardIndexMode::FULL, ForwardIndexMode::COMPACT }) {
+		SearchServer parallel("w0"s, mode);
+		SearchServer sequenced("w0"s, mode);
+		SearchServer one_by_one("w0"s, mode);
+		const auto assert_rejected = [&](const std::vector<RawDocument>& batch) {
+			for (SearchServer* search_server : { &parallel, &sequenced }) {
+				bool is_rejected = false;
+				try {
+					if (search_server == &parallel) {
+						search_server->AddDocuments(std::execution::par, batch);
+					}
+					else {
+						search_server->AddDocuments(std::execution::seq, batch);
+					}
+				}
+				catch (const std::invalid_argument&) {
+					is_rejected = true;
+				}
+				ASSERT(is_rejected);
+			}
+		};
+
+		for (int batch_begin = 0; batch_begin < 3000; batch_begin += 1000) {
+			std::vector<RawDocument> batch;
+			for (int id = batch_begin; id < batch_begin + 1000; ++id) {
+				batch.push_back({ id, texts[id], DocumentStatus::ACTUAL, { id } });
+				one_by_one.AddDocument(id, texts[id], DocumentStatus::ACTUAL, { id });
+			}
+			parallel.AddDocuments(std::execution::par, batch);
+			sequenced.AddDocuments(std::execution::seq, batch);
+
+			// a rejected batch changes nothing, even if most of it is valid;
+			// the texts are literals, RawDocument only views them
+			std::vector<RawDocument> invalid_batch = { { 5000 + batch_begin, "w1 w2", DocumentStatus::ACTUAL, { 1 } } };
+			invalid_batch.push_back({ batch_begin, "w3", DocumentStatus::ACTUAL, { 1 } });
+			assert_rejected(invalid_batch);
+			invalid_batch.back() = { 5000 + batch_begin, "w3", DocumentStatus::ACTUAL, { 1 } };
+			assert_rejected(invalid_batch);
+			invalid_batch.back() = { 6000 + batch_begin, "w3 w\x01", DocumentStatus::ACTUAL, { 1 } };
+			assert_rejected(invalid_batch);
+		}
+
+		for (const SearchServer* search_server : { &parallel, &sequenced }) {
+			ASSERT_EQUAL(search_server->GetDocumentCount(), one_by_one.GetDocumentCount());
+			for (const int id : one_by_one) {
+				ASSERT(search_server->GetWordFrequenciesCopy(id) == one_by_one.GetWordFrequenciesCopy(id));
+			}
+			// relevance is compared bit for bit
+			for (const std::string& query : queries) {
+				const auto documents = search_server->FindTopDocuments(query);
+				const auto expected = one_by_one.FindTopDocuments(query);
+				ASSERT_EQUAL_HINT(documents.size(), expected.size(), query);
+				for (size_t i = 0; i < documents.size(); ++i) {
+					ASSERT_EQUAL_HINT(documents[i].id, expected[i].id, query);
+					ASSERT_HINT(documents[i].relevance == expected[i].relevance, query);
+				}
+			}
+		}
+	}
+}
+
+void TestRemoveDocuments()
+{
+	const auto texts = MakeTestTexts(3000, 80);
+	const auto queries = MakeTestQueries();
+	std::vector<int> removed_ids = { -5, 123'456 };
+	for (int id = 0; id < 3000; id += 3) {
+		removed_ids.push_back(id);
+	}
+	for (const RemovalMode removal_mode : { RemovalMode::IMMEDIATE, RemovalMode::DEFERRED }) {
+		SearchServer sequenced("w0"s);
+		SearchServer parallel("w0"s);
+		SearchServer one_by_one("w0"s);
+		for (SearchServer* search_server : { &sequenced, &parallel, &one_by_one }) {
+			AddTestDocuments(*search_server, texts);
+			search_server->SetRemovalMode(removal_mode);
+		}
+		sequenced.RemoveDocuments(std::execution::seq, removed_ids);
+		parallel.RemoveDocuments(std::execution::par, removed_ids);
+		// any standard policy is accepted
+		for (const int id : removed_ids) {
+			one_by_one.RemoveDocument(std::execution::par_unseq, id);
+		}
+
+		for (const SearchServer* search_server : { &parallel, &one_by_one }) {
+			ASSERT_EQUAL(search_server->GetDocumentCount(), sequenced.GetDocumentCount());
+			ASSERT(std::equal(search_server->begin(), search_server->end(), sequenced.begin(), sequenced.end()));
+			for (const int id : sequenced) {
+				ASSERT(search_server->GetWordFrequencies(id) == sequenced.GetWordFrequencies(id));
+			}
+			for (const std::string& query : queries) {
+				AssertEqualDocuments(search_server->FindTopDocuments(query),
+					sequenced.FindTopDocuments(query), query);
+			}
+		}
+		ASSERT_EQUAL(sequenced.GetDocumentCount(), 2000);
+	}
+}
+
+void TestCompressedPostingsMemory()
+{
+	CountingMemoryResource resource;
+	SearchServer search_server("w0"s, &resource);
+	AddTestDocuments(search_server, MakeTestTexts(2000, 40));
+	const auto counted_bytes = [&resource] {
+		return static_cast<long long>(resource.GetStats().bytes_in_use);
+	};
+	const auto postings_bytes = [&search_server] {
+		return static_cast<long long>(search_server.GetMemoryStats().postings.bytes);
+	};
+	const long long plain_counted_bytes = counted_bytes();
+	const long long plain_postings_bytes = postings_bytes();
+
+	// the compressed lists, their tables included, come from the resource of the server
+	search_server.CompressPostings();
+	ASSERT(postings_bytes() < plain_postings_bytes);
+	ASSERT_EQUAL(counted_bytes() - plain_counted_bytes, postings_bytes() - plain_postings_bytes);
+
+	search_server.AddDocument(2000, "w1 w2 w3"s, DocumentStatus::ACTUAL, { 1 });
+	search_server.RemoveDocument(2000);
+	const auto documents = search_server.FindTopDocuments("w1 w2 w3"s);
+	ASSERT(!documents.empty());
+}
+
+void TestMemoryStats()
+{
+	const auto texts = MakeTestTexts(3000, 60);
+	for (const ForwardIndexMode mode : { ForwardIndexMode::FULL, ForwardIndexMode::COMPACT, ForwardIndexMode::NONE }) {
+		CountingMemoryResource resource;
+		SearchServer search_server("w0"s, &resource, mode);
+		// the stop words and the query cache do not use the resource of the server
+		const auto estimated_bytes = [&search_server] {
+			const auto stats = search_server.GetMemoryStats();
+			return static_cast<double>(stats.GetTotalBytes() - stats.stop_words.bytes - stats.query_cache.bytes);
+		};
+		const auto assert_tracks_counted_bytes = [&resource, &estimated_bytes](const std::string& hint) {
+			const double counted_bytes = static_cast<double>(resource.GetStats().bytes_in_use);
+			ASSERT_HINT(counted_bytes > 0.0, hint);
+			ASSERT_HINT(std::abs(estimated_bytes() - counted_bytes) < counted_bytes * 0.05, hint);
+		};
+
+		for (int id = 0; id < 3000; ++id) {
+			search_server.AddDocument(id, texts[id], DocumentStatus::ACTUAL, { id });
+			if (id % 1000 == 999) {
+				assert_tracks_counted_bytes("added "s + std::to_string(id + 1));
+			}
+		}
+
+		const size_t added_counted_bytes = resource.GetStats().bytes_in_use;
+		const double added_estimated_bytes = estimated_bytes();
+		for (int id = 0; id < 3000; id += 2) {
+			search_server.RemoveDocument(id);
+		}
+		assert_tracks_counted_bytes("removed"s);
+		if (mode == ForwardIndexMode::FULL) {
+			// the word maps of the removed documents are freed
+			ASSERT(resource.GetStats().bytes_in_use < added_counted_bytes);
+			ASSERT(estimated_bytes() < added_estimated_bytes);
+		}
+	}
+}
+
+void TestSearchServer()
+{
+	RUN_TEST(TestIndexSnapshot);
+	RUN_TEST(TestQueryCache);
+	RUN_TEST(TestDeferredRemoval);
+	RUN_TEST(TestRemoveDuplicates);
+	RUN_TEST(TestConcurrentSearchServer);
+	RUN_TEST(TestSegmentedIndex);
+	RUN_TEST(TestMaxScore);
+	RUN_TEST(TestForwardIndexModes);
+	RUN_TEST(TestStopWordFilter);
+	RUN_TEST(TestConcurrentMap);
+	RUN_TEST(TestProcessQueries);
+	RUN_TEST(TestByteMasks);
+	RUN_TEST(TestAddDocuments);
+	RUN_TEST(TestRemoveDocuments);
+	RUN_TEST(TestCompressedPostingsMemory);
+	RUN_TEST(TestMemoryStats);
+}
@@ -1,16 +1,19 @@
-#pragma once
-#include "search_server.h"
-
-void PrintDocument(const Document& document);
-
-void PrintMatchDocumentResult(int document_id, 
-	const std::vector<std::string>& words, DocumentStatus status);
-
-void AddDocument(SearchServer& search_server, int document_id, 
-	const std::string& document, DocumentStatus status, 
-	const std::vector<int>& ratings);
-
-void FindTopDocuments(const SearchServer& search_server, 
-	const std::string& raw_query);
-
-void MatchDocuments(const SearchServer& search_server, const std::string& query);
\ No newline at end of file
+#pragma once
+#include "search_server.h"
+
+void PrintDocument(const Document& document);
+
+void PrintMatchDocumentResult(int document_id, 
+	const std::vector<std::string_view>& words, DocumentStatus status);
+
+void AddDocument(SearchServer& search_server, int document_id, 
+	const std::string& document, DocumentStatus status, 
+	const std::vector<int>& ratings);
+
+void FindTopDocuments(const SearchServer& search_server, 
+	const std::string& raw_query);
+
+void MatchDocuments(const SearchServer& search_server, const std::string& query);
+
+// runs the unit tests, aborts on the first failed assertion
+void TestSearchServer();
\ No newline at end of file